@@ -4,6 +4,6 @@
 #include "structure.h"
 #include "main.h"
 
-void generateWholeCages(Main_t*, Options_t);
+int generateWholeCages(Main_t*, Options_t);
 
 #endif
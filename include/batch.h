@@ -0,0 +1,8 @@
+#ifndef __BATCH_H
+#define __BATCH_H
+
+#include "main.h"
+
+void runBatch(char* manifest, Options_t options);
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef __CACHE_H
+#define __CACHE_H
+
+#include "structure.h"
+
+unsigned long cacheKey(Molecule_t*, double, int);
+char* cacheFile(char*, unsigned long);
+Main_t* readCache(char*, Molecule_t*);
+void writeCache(char*, Main_t*);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef __CAGEMOL_H
+#define __CAGEMOL_H
+
+#include "structure.h"
+#include "main.h"
+
+// Context of the generation of the cages of a substrate (opaque).
+// It keeps the substrate, its envelopes and their caches from a run to the next one.
+typedef struct CageMol CageMol_t;
+
+// Job of a parameter grid, run from the pathless cages of an alpha value.
+typedef struct {
+
+	int sizeMax;
+	int maxResults;
+	int nbResults; // Set by the run.
+} Job_t;
+
+CageMol_t* CGM_create(Options_t options, int* error);
+int CGM_isCached(Options_t options);
+int CGM_run(CageMol_t* c, Result_f onResult, void* data);
+int CGM_runGrid(CageMol_t* c, int i, Job_t* jobs, int nbJobs);
+void CGM_delete(CageMol_t* c);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef __CHECKPOINT_H
+#define __CHECKPOINT_H
+
+#include "structure.h"
+
+void installCheckpointSignal();
+int checkpointSignal();
+void writeCheckpoint(char*, char*, Deque_t**, int, Table_t*, int, long);
+char* readCheckpointOutput(char*);
+int readCheckpoint(char*, Deque_t*, Table_t*, int*, long*);
+
+#endif
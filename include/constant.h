@@ -2,16 +2,119 @@
 #define __CONSTANT_H
 
 // Main
-#define OPTSTR "i:a:s:r:h"
-#define USAGE_FMT  "usage : [-i inputfile] [-a alpha (default : %1.f)] [-s sizemax (default : %d)] [-r maxresults (default : %d)] [-h]\n"
+#define OPTSTR "i:a:s:r:e:h"
+#define USAGE_FMT  "usage : [-i inputfile] [-a alpha or list of alphas a1,a2,... (default : %1.f)] [-s sizemax (default : %d)] [-r maxresults (default : %d)] [-e envelope engine r|native (default : %s)] [--search=dfs|iddfs|beam|astar|bidir (default : %s)] [--deadline=seconds] [--max-nodes=n] [--max-pair-nodes=n] [--checkpoint=file [--checkpoint-interval=seconds] [--resume]] [--workers=n] [--serve=socket [--workers=n (default : %d)]] [--batch=manifest.tsv] [--cache=directory] [-h]\n" \
+	"  --checkpoint : the cages waiting to be searched are saved, not the path search of a pair in progress (it restarts from its first path on --resume).\n" \
+	"  --workers : number of processes sharing the search of the substrate, or with --serve, number of processes serving the jobs (each job is then searched by a single process).\n"
 #define DEFLT_ALPHA 3.
 #define DEFLT_SIZEMAX 5
 #define DEFLT_MAX_RESULTS 10
 
-#define PATHNAME "alphashape.R"
+// Search of the paths between the groupings of patterns (long option --search).
+#define OPT_SEARCH 256
+#define SEARCH_DFS 0 // Exhaustive depth-first search.
+#define SEARCH_BEAM 1 // Level by level, only the BEAM_WIDTH best partial paths are kept.
+#define SEARCH_ASTAR 2 // Best partial path first, at most FRONTIER_SIZE partial paths are kept.
+#define SEARCH_BIDIR 3 // Half paths from both atoms, joined when their last atoms can be bonded.
+#define SEARCH_IDDFS 4 // Size limit increased up to sizeMax, the partial paths of each size expanded once (shortest paths first).
+#define DEFLT_SEARCH SEARCH_DFS
+#define SEARCH_NAME(s) ((s) == SEARCH_BEAM ? "beam" : ((s) == SEARCH_ASTAR ? "astar" : ((s) == SEARCH_BIDIR ? "bidir" : ((s) == SEARCH_IDDFS ? "iddfs" : "dfs"))))
+
+// Budgets of the search (long options, 0 if not limited).
+#define OPT_DEADLINE 257 // Wall clock time (in seconds from the start).
+#define OPT_MAX_NODES 258 // Number of nodes of the path search.
+#define OPT_MAX_PAIR_NODES 259 // Number of nodes of the path search of each pair.
+#define STOP_NONE 0
+#define STOP_RESULTS 1
+#define STOP_NODES 2
+#define STOP_DEADLINE 3
+#define STOP_CHECKPOINT 4 // The frontier is written in the checkpoint file (SIGTERM or interval).
+#define STOP_CALLER 5 // The result callback asked to stop.
+#define STOP_NAME(s) ((s) == STOP_RESULTS ? "maximum number of results" : ((s) == STOP_NODES ? "maximum number of nodes" : ((s) == STOP_DEADLINE ? "deadline" : ((s) == STOP_CHECKPOINT ? "checkpoint" : ((s) == STOP_CALLER ? "caller request" : "none")))))
+
+// Checkpoint of the frontier of the search (long options).
+#define OPT_CHECKPOINT 260 // File of the checkpoint, written on SIGTERM.
+#define OPT_CHECKPOINT_INTERVAL 261 // Also written every interval (in seconds).
+#define OPT_RESUME 262 // The search is resumed from the checkpoint file.
+#define CHECKPOINT_MAGIC "CAGECKP3"
+
+// Server of jobs on a Unix domain socket (long options).
+#define OPT_SERVE 263 // Path of the socket.
+#define OPT_WORKERS 264 // Number of processes of the search of a substrate, or of the server with --serve.
+#define DEFLT_WORKERS 2 // Of the server (the search is not sharded by default).
+#define SERVER_BACKLOG 16 // Connections waiting for a worker.
+#define SERVER_LINE_SIZE 256 // Maximal length of a line of a job.
+#define SERVER_SUBSTRATE "/tmp/cageMolXXXXXX" // Temporary file of the substrate of a job.
+
+// Batch of jobs read in a manifest (long option).
+#define OPT_BATCH 265 // File of the manifest (substrate, alpha, sizeMax, maxResults by line).
+#define BATCH_LINE_SIZE 1024 // Maximal length of a line of the manifest.
+
+// Cache of the pathless cages (long option).
+#define OPT_CACHE 266 // Directory of the cache.
+#define CACHE_MAGIC "CAGECCH1"
+#define CACHE_VERSION 3 // To be increased when the generation of the envelope or of the patterns changes.
+#define CACHE_FNV_OFFSET 14695981039346656037UL // Hash of the keys (FNV-1a).
+#define CACHE_FNV_PRIME 1099511628211UL
+
+// Search shared between processes (--workers without --serve).
+#define SHARD_SPOOL "%s/%s/shard%d" // Directory of the results of a worker (in the results of the substrate).
+
+// Engine used to compute the alpha shape of the envelope.
+#define ENGINE_R 0
+#define ENGINE_NATIVE 1
+#ifdef WITHOUT_R
+#define DEFLT_ENGINE ENGINE_NATIVE
+#else
+#define DEFLT_ENGINE ENGINE_R
+#endif
+#define ENGINE_NAME(e) ((e) == ENGINE_R ? "r" : "native")
+
+#define PATHNAME "src/alphashape.R" // From the directory where the program is launched.
+#define RESULTS_DIR "results" // Directory of the result files (from the directory where the program is launched).
+#define RDC_FILE "resources/rdc.dat" // Covalent radii (from the directory where the program is launched).
+
+// Errors of the input files (the substrate and the covalent radii).
+#define INPUT_OK 0
+#define INPUT_UNREADABLE 1
+#define INPUT_INVALID_SIZE 2
+#define INPUT_INVALID_ATOM 3
+#define INPUT_UNKNOWN_ELEMENT 4 // Not in the table of the covalent radii.
+#define INPUT_INVALID_RADII 5
+#define INPUT_ERROR_NAME(e) ((e) == INPUT_UNREADABLE ? "unreadable file" : ((e) == INPUT_INVALID_SIZE ? "invalid number of atoms" : ((e) == INPUT_INVALID_ATOM ? "invalid atom" : ((e) == INPUT_UNKNOWN_ELEMENT ? "unknown element" : ((e) == INPUT_INVALID_RADII ? "invalid covalent radii" : "none")))))
+#define INPUT_SYMBOL_SIZE 3 // Symbol of an element (2 characters at most).
+#define INPUT_LINE_SIZE 256 // Maximal length of a word of the input files.
 
 // Structure
 #define REALLOCSIZE 4 // TODO could it be decreased? 
+#define GRID_CELL_SIZE DIST_GAP_SUBSTRATE // Size of a cell of the spatial hash (largest distance of the clash tests).
+#define GRID_NB_CELLS 256 // Number of buckets of the spatial hash (power of 2).
+#define FIELD_VOXEL_SIZE 0.25 // Size of a voxel of the occupancy field of the substrate.
+#define FIELD_MARGIN 0.001 // Margin for the rounding errors of the occupancy field.
+#define FIELD_FREE 0
+#define FIELD_BLOCKED 1
+#define FIELD_BOUNDARY 2
+#define TRAIL_SIZE 64 // Initial number of changes of a trail.
+#define TRAIL_ATOM 0
+#define TRAIL_EDGE 1
+#define TRAIL_FLAG 2
+
+// Parallel path search
+#define TASK_DEPTH 2 // Depth (number of inserted patterns) under which the moves are explored in OpenMP tasks.
+#define DEQUE_SIZE 64 // Growth of the work-stealing deque of a thread.
+#define PIPE_SIZE 256 // Results waiting for the writing stage (a full pipe is bypassed).
+#define BEAM_WIDTH 64 // Number of partial paths kept at each level of the beam search.
+#define FRONTIER_SIZE 4096 // Maximal number of partial paths waiting in the best-first search.
+#define ANGLE_COST 180. // Angle deviation (in degrees) counting as one atom in the cost of a partial path.
+#define TABLE_SIZE (1 << 18) // Maximal number of keys kept in the table of the searched cages.
+#define TABLE_STRIPE_BITS 6 // The table is split in 2^TABLE_STRIPE_BITS stripes with their own lock.
+#define TABLE_QUANTUM 0.01 // Step of the quantization of the positions in the fingerprints.
+
+// Native alpha shape (Delaunay triangulation)
+#define NB_SUPER_VERTICES 4 // Vertices of the tetrahedron enclosing the cloud of points.
+#define DEL_SUPER_SCALE 20. // Size of the enclosing tetrahedron relative to the cloud of points.
+#define DEL_DUPLICATE 1e-6 // Two points closer than this distance are considered as duplicated.
+#define DEL_FLAT 1e-12 // Relative volume under which a tetrahedron is considered as flat.
 
 // Initialization of the substrate
 #define EDGE_ERROR 20 // Acceptable error for the computation of the edges between atoms
@@ -34,6 +137,7 @@ A___/   \___B
     \___/
 */
 #define NB_ATOMS_IN_CYCLE 7 // Number of atoms in an aromatic ring pattern.
+#define DIST_PATH_STEP 1.31 // Largest advance of a path per added atom (AC/2 with AB = BC = 1.5 and angle ABC = 120°, rounded up).
 
 // Distance in generateCycle (TODO document why these values were chosen)
 #define SIMPLE_CYCLE 1.4 // Simple covalent bond size between an atom involved in a cycle and a neighboring atom outside of the cycle.
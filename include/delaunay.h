@@ -0,0 +1,8 @@
+#ifndef __DELAUNAY_H
+#define __DELAUNAY_H
+
+#include "structure.h"
+
+Ashape_t** Nashape3d(Shell_t*, double* alphas, int nbAlphas);
+
+#endif
@@ -3,7 +3,7 @@
 
 #include "structure.h"
 
-Shell_t* createShell(Molecule_t* m, double alpha);
+Shell_t** createShell(Molecule_t* m, double* alphas, int nbAlphas, int engine);
 void expansion(Molecule_t* m, Shell_t* s);
 
 #endif
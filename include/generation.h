@@ -3,6 +3,7 @@
 
 #include "structure.h"
 
+Shell_t* generatePathlessCage(Main_t*, Dependencies_t*, unsigned long*);
 void generatePathlessCages(Main_t*);
 
 #endif
@@ -3,6 +3,6 @@
 
 #include "structure.h"
 
-Molecule_t* initMolecule(char*);
+Molecule_t* initMolecule(char*, char*, int*);
 
 #endif
@@ -3,7 +3,8 @@
 
 #include "structure.h"
 
-Molecule_t* readInput_xyz(char*);
-void readCovalence(Molecule_t*);
+Molecule_t* readInput_xyz(char*, int*);
+int readRadii(char*);
+int readCovalence(Molecule_t*, char*);
 
 #endif
@@ -3,7 +3,7 @@
 
 #include "structure.h"
 
-Ashape_t* Cashape3d(Shell_t*, double alpha);
+Ashape_t** Cashape3d(Shell_t*, double* alphas, int nbAlphas);
 int* Cinashape3d(Ashape_t*, double*, int);
 
 #endif
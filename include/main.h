@@ -1,15 +1,39 @@
 #ifndef _MAIN_H
 #define _MAIN_H
 
+#include "structure.h"
+
+// Called for each connected cage instead of writing it (the cage belongs to the search, SHL_copy to keep it).
+// The calls are serialized between the threads. A nonzero return value stops the search.
+typedef int (*Result_f)(Shell_t* cage, int index, void* data);
+
 typedef struct {
   char*         input;
-  double				alpha;
+  double*				alphas;
+  int					nbAlphas;
+  char*					output;
 	int					sizeMax;
   int      maxResults;
+  int      engine;
+  int      search;
+  double   deadline; // Wall clock time (omp_get_wtime) at which the search stops, 0 if not limited.
+  long     maxNodes;
+  long     maxPairNodes;
+  char*    checkpoint; // File of the checkpoint, NULL if none.
+  double   checkpointInterval; // Seconds between two checkpoints, 0 for SIGTERM only.
+  int      resume;
+  char*    results; // Directory of the result files.
+  char*    radii; // File of the covalent radii.
+  Result_f onResult; // NULL to write the result files.
+  void*    resultData; // Given to onResult.
+  char*    serve; // Socket of the server, NULL to process the input file.
+  int      workers; // Number of processes of the server, or of the search (0 : default).
+  char*    batch; // Manifest of the jobs, NULL to process the input file.
+  char*    cache; // Directory of the cache of the pathless cages, NULL if not used.
 } Options_t;
 
 void usage();
+void parseAlphas(char*, Options_t*);
 void source(const char*);
-void setWorkingDirectory(char*);
 
 #endif
\ No newline at end of file
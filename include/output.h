@@ -3,15 +3,17 @@
 
 #include "structure.h"
 
-char* createDir(char *);
+char* createDir(char*, char *);
+char* createUnderDir(char*, char*, int);
 char* getBasename (char *);
 void LST_write(List_t*);
 void MOL_write(Molecule_t*);
 void SHL_write(Shell_t*);
 void GPH_write(Graph_t*) ;
 void MOL_writeMol2(char*, Molecule_t*);
+int SHL_printMol2(FILE*, Shell_t*);
 void SHL_writeMol2(char*, Shell_t*);
-void writeMainOutput(char*, Main_t*);
-void writeShellOutput(char* InputFile, Shell_t* s, int tailleMocInit);
+void writeMainOutput(char*, char*, Main_t*);
+void writeShellOutput(char* results, char* name, Shell_t* s, int tailleMocInit, int i);
 
 #endif
@@ -0,0 +1,8 @@
+#ifndef __SERVER_H
+#define __SERVER_H
+
+#include "main.h"
+
+void serve(char* path, Options_t options);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef __SHARD_H
+#define __SHARD_H
+
+#include "structure.h"
+#include <sys/types.h>
+
+// Results of a worker of a sharded search, spooled until they are merged (opaque).
+typedef struct Spool Spool_t;
+
+pid_t* forkShards(int nbShards, int* shard);
+void keepShard(Deque_t* d, int shard, int nbShards, int* pending);
+Spool_t* SPL_create(char* results, char* output, int shard);
+void spoolResult(Spool_t* s, Shell_t* cage, int n, int nbMotifs);
+void exitShard(Spool_t* s, Main_t* m, int nbResults);
+int mergeShards(char* results, char* output, pid_t* pids, int nbShards, int countResults, int maxResults);
+
+#endif
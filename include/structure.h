@@ -5,6 +5,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include "constant.h"
+#include <omp.h>
+#include <pthread.h>
 
 //retourne l'adresse
 #define atom(o,i) ((o)->atoms+(i)) //adresse de l'atome
@@ -56,6 +58,9 @@
 #define moc(m,i) (m)->mocs[i]
 #define mocSize(m) (m)->mocSize
 
+//macro trail
+#define nbChanges(t) (t)->nbChanges
+
 
 typedef struct {
 	float x;
@@ -134,12 +139,68 @@ typedef struct {
 	unsigned size;
 } Graph_t;
 
+/**************************************/
+/* GRID *******************************/
+/**************************************/
+// Spatial hash of the atoms (cell list) for the distance queries.
+// The atoms of a bucket are chained with next, starting at head.
+typedef struct {
+
+	float cellSize;
+	unsigned nbCells;
+	int* head; // First atom of each bucket (-1 if empty).
+
+	int* next; // Next atom in the same bucket (-1 at the end).
+	int* bucket; // Bucket of each atom (-1 if not in the grid).
+	Point_t* coords;
+	unsigned size;
+} Grid_t;
+
+/**************************************/
+/* FIELD ******************************/
+/**************************************/
+// Occupancy field of a molecule (voxels FIELD_FREE, FIELD_BLOCKED or FIELD_BOUNDARY).
+typedef struct {
+
+	Point_t origin;
+	float voxelSize;
+	int nx, ny, nz;
+	char* voxels;
+} Field_t;
+
+/**************************************/
+/* PARTITION **************************/
+/**************************************/
+// Connected components of the atoms (union-find), parent of the root is itself.
+typedef struct {
+
+	int* parent;
+	unsigned size;
+} Partition_t;
+
+/**************************************/
+/* DEPENDENCIES ***********************/
+/**************************************/
+// Conflicts between the binding patterns (vertices of the dependency graph) as bitsets,
+// and the lazy enumeration of the maximal sets of compatible patterns
+// (Bron-Kerbosch with pivot on the complement graph, with an explicit stack).
+typedef struct {
+
+	int nbVertices;
+	int nbWords; // Words of a set of vertices.
+	int* ids; // Atom of the shell of each vertex.
+	unsigned long* conflicts; // Set of the conflicting vertices of each vertex.
+	unsigned long* frames; // Stack of the enumeration, 4 sets by frame : set built, candidates, excluded, candidates left.
+	int depth; // Top frame of the stack, -1 once the enumeration is over.
+	long nbSets; // Number of sets enumerated.
+} Dependencies_t;
+
 /**************************************/
 /* MOLECULE ***************************/
 /**************************************/
 typedef struct {
 
-	char symbol[2];
+	char symbol[INPUT_SYMBOL_SIZE];
 	int radius;
 	int ligands;
 	int lonePairs;
@@ -160,6 +221,8 @@ typedef struct {
 	Atom_t* atoms;
 	List_t* cycle; // liste des sommets appartenant à un cycle
 	Graph_t* bond;
+	Grid_t* grid; // Index of the atoms, NULL if not built.
+	Field_t* field; // Occupancy field at DIST_GAP_SUBSTRATE, NULL if not built.
 	unsigned size;
 } Molecule_t;
 
@@ -183,13 +246,108 @@ typedef struct {
 	AtomShl_t* atoms;
 	List_t* cycle;
 	Graph_t* bond;
+	Grid_t* grid; // Index of the atoms, NULL if not built (kept up to date by SHL_ functions).
 
 	unsigned size;
 } Shell_t;
 
+/**************************************/
+/* TRAIL ******************************/
+/**************************************/
+// Modification of a shell (TRAIL_ATOM, TRAIL_EDGE or TRAIL_FLAG).
+typedef struct {
+
+	int type;
+	int id1;
+	int id2; // Second atom of an edge, new flag of a TRAIL_FLAG.
+	int flag; // Flag of an added atom, previous flag of a TRAIL_FLAG.
+	Point_t coords;
+} Change_t;
+
+// Journal of the modifications of a shell, undone in reverse order.
+// A part of a trail is also a move that can be replayed on the same state of the shell.
+typedef struct {
+
+	Change_t* changes;
+	unsigned nbChanges;
+	unsigned size;
+} Trail_t;
+
+/**************************************/
+/* PRIORITY QUEUE *********************/
+/**************************************/
+// Partial path of a best-first search, built by replaying its changes on the cage.
+typedef struct {
+
+	Trail_t* path;
+	int idStart; // Last atom of the path.
+	int nbCarbonyls;
+	int nbAroRings;
+	int nbAtoms; // Number of atoms of the path (half paths of the bidirectional search).
+	float cost;
+	long order; // Order of insertion (breaks the ties).
+} State_t;
+
+// Bounded binary heap of partial paths (lowest cost first).
+typedef struct {
+
+	State_t** states;
+	int nbStates;
+	long nbPushed;
+	long nbDropped; // States deleted because the queue was full.
+	unsigned size;
+} Queue_t;
+
+/**************************************/
+/* TABLE OF THE CAGES *****************/
+/**************************************/
+// Key of a processed cage, chained in its bucket and in the LRU list of its stripe.
+typedef struct {
+
+	unsigned long key;
+	int next; // Next slot of the bucket (-1 at the end).
+	int older; // LRU list (-1 at the ends).
+	int newer;
+} Slot_t;
+
+// Part of the table protected by its own lock.
+typedef struct {
+
+	Slot_t* slots;
+	int* heads; // First slot of each bucket (-1 if empty).
+	int nbSlots; // Number of used slots.
+	int oldest; // Least recently used slot.
+	int newest;
+	long nbLookups;
+	long nbHits;
+	long nbEvictions;
+	omp_lock_t lock;
+	unsigned size;
+} Stripe_t;
+
+// Bounded set of the processed cages of the search (with LRU eviction).
+typedef struct {
+
+	Stripe_t* stripes;
+	int nbStripes;
+} Table_t;
+
 /**************************************/
 /* MAIN *******************************/
 /**************************************/
+// Budgets of the search of the cages (shared by the threads).
+typedef struct {
+
+	int stop; // Reason of the end of the search (STOP_NONE while it goes on).
+	long nbNodes; // Number of nodes of the path search.
+	long maxNodes; // 0 if not limited.
+	long maxPairNodes; // Budget of the path search of each pair, 0 if not limited.
+	long nbPrunedDistance; // Partial paths too far from the end atom.
+	long nbPrunedCycle; // Partial paths too short to contain a ring.
+	double deadline; // Wall clock time (omp_get_wtime) of the end of the search, 0 if not limited.
+	double checkpoint; // Wall clock time of the next checkpoint (HUGE_VAL on SIGTERM only), 0 if none.
+} Budget_t;
+
 typedef struct {
 
 	Molecule_t* substrat;
@@ -197,6 +355,10 @@ typedef struct {
 	Shell_t* envarom;
 	Shell_t** mocs;
 	unsigned mocSize;
+	Table_t* cages; // Processed cages (kept in the checkpoints).
+	Budget_t budget;
+	struct Spool* spool; // Results of a worker of a sharded search (see shard.h), NULL otherwise.
+	struct Pipe* pipe; // Results waiting for the writing stage, NULL if the search threads write them.
 
 } Main_t;
 
@@ -234,6 +396,90 @@ typedef struct {
 	Elem *first;	
 } List_m;
 
+// Liste des modifications (moves) a rejouer
+typedef struct Elem_r Elem_r;
+struct Elem_r {
+	
+	Trail_t* move;
+	Elem_r *next;	
+};
+
+typedef struct {
+	
+	Elem_r *first;	
+} List_r;
+
+/**************************************/
+/* WORK-STEALING **********************/
+/**************************************/
+// Pairs of atoms of the same cage, their results are merged in the order of the pairs.
+typedef struct {
+
+	Shell_t* moc; // Cage to connect (shared by the pairs, read only).
+	Partition_t* components; // Connected components of the cage.
+	List_m** results; // Cages generated from each pair.
+	int* starts; // Atoms of each pair.
+	int* ends;
+	int nbPairs;
+	int remaining; // Number of pairs not yet processed.
+	int interrupted; // 1 if a pair was interrupted by a checkpoint (the cage is written in the checkpoint).
+	int pathlessSize; // Size of the pathless cage of the cage.
+} Group_t;
+
+// Item of the frontier: a cage whose pairs must be chosen (start = -1)
+// or a pair of atoms of a cage to connect.
+typedef struct {
+
+	Shell_t* moc; // Cage (NULL for a pair, the cage is in the group).
+	int start;
+	int end;
+	Group_t* group;
+	int index; // Index of the pair in its group.
+	Partition_t* components; // Connected components of a cage (NULL for a pair).
+	int resumed; // Cage of a checkpoint (it may already be in the processed cages).
+	int pathlessSize; // Size of the pathless cage the item comes from (before the addition of the paths).
+} Work_t;
+
+// Double-ended queue of a thread: the owner works at the bottom, the other threads steal at the top.
+typedef struct {
+
+	Work_t** items;
+	int top;
+	int bottom;
+	int size;
+	omp_lock_t lock;
+} Deque_t;
+
+// Search threads without work, asleep until the frontier changes (items pushed or processed, a thread stopped).
+typedef struct {
+
+	long epoch; // Number of changes of the frontier.
+	int nbIdle;
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+} Idle_t;
+
+// Connected cage waiting to be written.
+typedef struct {
+
+	Shell_t* moc;
+	int n; // Index of the result.
+	int pathlessSize; // Size of its pathless cage.
+} Result_t;
+
+// Bounded queue between the search threads and the writing stage (first in, first out).
+// The writing stage sleeps on a condition variable (OpenMP has none) until a result is pushed or the pipe is closed.
+typedef struct Pipe {
+
+	Result_t* items;
+	int first; // Oldest item.
+	int nbItems;
+	int size; // Capacity.
+	int closed; // 1 once the search threads are stopped.
+	pthread_mutex_t lock;
+	pthread_cond_t ready;
+} Pipe_t;
+
 
 //Point
 Point_t PT_init();
@@ -267,8 +513,14 @@ void LST2_delete(List_p* list);
 List_m* LSTm_init();
 void LSTm_addElement(List_m* list, Shell_t* moc);
 void LSTm_removeFirst(List_m* list);
+void LSTm_addList(List_m* list, List_m* added);
 void LSTm_delete(List_m* list);
 
+List_r* LSTr_init();
+void LSTr_addElement(List_r* list, Trail_t* move);
+void LSTr_removeFirst(List_r* list);
+void LSTr_delete(List_r* list);
+
 List_s* LSTs_init();
 void LSTs_addElement(List_s* list, Point_t sommet);
 void LSTs_removeFirst(List_s* list);
@@ -315,12 +567,14 @@ Molecule_t* MOL_create(unsigned);
 void MOL_deleteAtom(Atom_t*);
 void MOL_delete(Molecule_t*);
 
+void SHL_initAtom(AtomShl_t*);
 int SHL_nbNeighborhood(AtomShl_t*);
 int SHL_nbAtom(Shell_t*);
 int SHL_nbEdges(Shell_t*);
 void SHL_addEdge(Shell_t*, unsigned, unsigned);
 void SHL_removeEdge(Shell_t*, unsigned, unsigned);
 unsigned SHL_addAtom(Shell_t*, Point_t, unsigned);
+int SHL_getAtoms(Shell_t*, Point_t, float, List_t*);
 void SHL_removeAtom(Shell_t*, unsigned);
 unsigned SHL_addVertex(Shell_t*, unsigned);
 void SHL_removeVertex(Shell_t*, unsigned);
@@ -341,6 +595,77 @@ void SHL_deleteAtom(AtomShl_t* a);
 Graph_t* MolToGph(Molecule_t*);
 Graph_t* ShlToGph(Shell_t*);
 
+void GRD_addAtom(Grid_t*, unsigned, Point_t);
+void GRD_removeAtom(Grid_t*, unsigned);
+int GRD_checkDistance(Grid_t*, Point_t, float, int);
+int GRD_getAtoms(Grid_t*, Point_t, float, List_t*);
+Grid_t* GRD_create(float, unsigned);
+Grid_t* GRD_createFromShell(Shell_t*);
+Grid_t* GRD_createFromMolecule(Molecule_t*);
+Grid_t* GRD_copy(Grid_t*);
+void GRD_delete(Grid_t*);
+
+int FLD_check(Field_t*, Point_t);
+Field_t* FLD_create(Molecule_t*, float, float);
+void FLD_delete(Field_t*);
+
+int PRT_find(Partition_t*, int);
+void PRT_union(Partition_t*, int, int);
+Partition_t* PRT_create(unsigned);
+Partition_t* PRT_createFromShell(Shell_t*);
+Partition_t* PRT_copy(Partition_t*);
+void PRT_delete(Partition_t*);
+
+int DEP_check(Dependencies_t*, unsigned long*, int);
+unsigned long* DEP_next(Dependencies_t*);
+Dependencies_t* DEP_create(Graph_t*);
+void DEP_delete(Dependencies_t*);
+
+unsigned TRL_addAtom(Trail_t*, Shell_t*, Point_t, int);
+void TRL_addEdge(Trail_t*, Shell_t*, unsigned, unsigned);
+void TRL_setFlag(Trail_t*, Shell_t*, unsigned, int);
+void TRL_undo(Trail_t*, Shell_t*, unsigned);
+int TRL_replay(Trail_t*, Shell_t*, Trail_t*);
+Trail_t* TRL_copy(Trail_t*, unsigned);
+Trail_t* TRL_create();
+void TRL_delete(Trail_t*);
+
+Work_t* WRK_create(Shell_t*, int, int, Group_t*, int);
+void WRK_delete(Work_t*);
+Group_t* GRP_create(Shell_t*, Partition_t*, int);
+void GRP_delete(Group_t*);
+Deque_t* DEQ_create();
+void DEQ_delete(Deque_t*);
+void DEQ_push(Deque_t*, Work_t*);
+Work_t* DEQ_pop(Deque_t*);
+Work_t* DEQ_steal(Deque_t*);
+Idle_t* IDL_create();
+void IDL_delete(Idle_t*);
+long IDL_epoch(Idle_t*);
+void IDL_wait(Idle_t*, long);
+void IDL_notify(Idle_t*);
+Pipe_t* PIP_create(int);
+void PIP_delete(Pipe_t*);
+int PIP_push(Pipe_t*, Shell_t*, int, int);
+int PIP_pop(Pipe_t*, Result_t*);
+void PIP_open(Pipe_t*);
+void PIP_close(Pipe_t*);
+
+State_t* STA_create(Trail_t*, int, int, int, float);
+void STA_delete(State_t*);
+void QUE_push(Queue_t*, State_t*);
+State_t* QUE_pop(Queue_t*);
+Queue_t* QUE_create(unsigned);
+void QUE_delete(Queue_t*);
+
+unsigned long TBL_mix(unsigned long);
+unsigned long TBL_hashPoint(Point_t);
+unsigned long TBL_fingerprint(Shell_t*);
+int TBL_checkAndInsert(Table_t*, unsigned long);
+void TBL_stats(Table_t*, long*, long*, long*);
+Table_t* TBL_create(unsigned);
+void TBL_delete(Table_t*);
+
 Ashape_t* ASP_create();
 void ASP_delete(Ashape_t*);
 
@@ -1,25 +1,50 @@
 #include "assembly.h"
 #include "util.h"
 #include "output.h"
+#include "checkpoint.h"
+#include "shard.h"
+#include "generation.h"
 #include "constant.h"
 #include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 /**
  * @brief Checks if a point is far enough away from the other atoms 
- * of the cage and those of the substrate.
+ * of the cage (except one) and those of the substrate.
+ * The grids of the cage and of the substrate, and the occupancy field 
+ * of the substrate are used when they are built.
  * 
  * @param moc Molecular cage being generated.
  * @param sub Substrate molecule.
  * @param p  Point (atom) tested.
+ * @param except Index of an atom of the cage ignored (-1 to test all the atoms).
  * @return (int) 1 if not far enough, 0 otherwise.
  */
-int isHindered(Shell_t* moc, Molecule_t* sub, Point_t p) {
+int isHinderedExcept(Shell_t* moc, Molecule_t* sub, Point_t p, int except) {
 
-	for (int i = 0; i < size(moc); i++) {
+	if (moc->grid != NULL) {
+		if (GRD_checkDistance(moc->grid, p, DIST_GAP_CAGE, except))
+			return 1;
+	}
+	else {
+		for (int i = 0; i < size(moc); i++) {
 			Point_t A = coords(atom(moc, i));
-			if (dist(A, p) < DIST_GAP_CAGE)
+			if (i != except && flag(atom(moc, i)) != NOT_DEF_F && dist(A, p) < DIST_GAP_CAGE)
 				return 1;
+		}
 	}
+
+	if (sub->field != NULL) {
+		int state = FLD_check(sub->field, p);
+		if (state != FIELD_BOUNDARY)
+			return state == FIELD_BLOCKED;
+	}
+
+	if (sub->grid != NULL)
+		return GRD_checkDistance(sub->grid, p, DIST_GAP_SUBSTRATE, -1);
+
 	for (int i = 0; i < size(sub); i++) {
 		Point_t A = coords(atom(sub, i));
 		if (dist(A, p) < DIST_GAP_SUBSTRATE) 
@@ -28,6 +53,20 @@ int isHindered(Shell_t* moc, Molecule_t* sub, Point_t p) {
 	return 0;
 }
 
+/**
+ * @brief Checks if a point is far enough away from the other atoms 
+ * of the cage and those of the substrate.
+ * 
+ * @param moc Molecular cage being generated.
+ * @param sub Substrate molecule.
+ * @param p  Point (atom) tested.
+ * @return (int) 1 if not far enough, 0 otherwise.
+ */
+int isHindered(Shell_t* moc, Molecule_t* sub, Point_t p) {
+
+	return isHinderedExcept(moc, sub, p, -1);
+}
+
 /**************************************/
 /********* Patterns addition **********/
 /**************************************/
@@ -51,87 +90,73 @@ int insertType(int numPattern) {
 	}
 }
 
+// Aromatic ring pattern in the frame of its first atom, in SIMPLE_CYCLE units: along the bond 
+// from the starting atom, then in the plane of the ring. The ring is a regular hexagon 
+// and the path continues from the atom opposite to the first one.
+static const float ringTemplate[NB_ATOMS_IN_CYCLE - 1][2] = {
+	{0, 0}, {0.5, 0.8660254}, {1.5, 0.8660254}, {2, 0}, {1.5, -0.8660254}, {0.5, -0.8660254}
+};
+#define RING_EXIT 3 // Atom of the ring bonded to the atom after the ring.
+
 /**
  * @brief Adds an aromatic ring (pattern 4) perpendicular to the plane 
  * with its neighbor.
+ * The positions of the ring and of the atom after it are placed at once from ringTemplate,
+ * and tested before the ring is built in the cage, recorded as a move and undone.
  * 
  * @param processedMoc Molecular cage being generated.
- * @param mocsInProgress List of cages in construction to be processed.
+ * @param trail Trail of the modifications of the cage.
+ * @param moves Stack of moves (additions) to be processed.
  * @param idStart Index of the first linkable atom in the path in construction.
  * @param newStarts Stack of atoms starting a path in construction.
  * @param newStartPos Position (point) of the next atom added in the path.
  * @param sub Substrate molecule.
  */
-void addAromaticRing(Shell_t* processedMoc, List_m* mocsInProgress, int idStart, List_d* newStarts, Point_t newStartPos, Molecule_t* sub) {
+void addAromaticRing(Shell_t* processedMoc, Trail_t* trail, List_r* moves, int idStart, List_d* newStarts, Point_t newStartPos, Molecule_t* sub) {
 	
+	Point_t zero = {0, 0, 0};
+	Point_t startPos = coords(atom(processedMoc, idStart));
+	Point_t bond = normalization(vector(startPos, newStartPos), 1);
+
 	for (int i = 0; forEachNeighbor((atom(processedMoc,idStart)), i); i++) { // For every possible plans with starting atom's neighbors
-		int idNext, idAtomCycle;
-		Point_t nextPos;
-		Point_t copyNewStartPos = newStartPos;
-		Shell_t* moc = SHL_copy(processedMoc);
-			
-		Point_t neighborStartPos = coords(atom(moc, neighbor(atom(moc, idStart), i)));
-		Point_t startPos = coords(atom(moc, idStart));
+		Point_t positions[NB_ATOMS_IN_CYCLE];
+		int ids[NB_ATOMS_IN_CYCLE];
+		unsigned mark = nbChanges(trail);
+		Point_t neighborStartPos = coords(atom(processedMoc, neighbor(atom(processedMoc, idStart), i)));
 			
-		// Add the first ring atom of already known position.
-		int idnewStart = SHL_addAtom(moc, copyNewStartPos, -1);
-		flag(atom(moc, idnewStart)) = CARBON_F;
-		SHL_addEdge(moc, idStart, idnewStart);
-
 		// Look for the normal to position the ring.
-		Point_t normal = planNormal(copyNewStartPos, startPos, neighborStartPos);
-		normal = rotation(normalization(vector(copyNewStartPos, startPos), 1),  90, normal); // Perpendicular
-			
-		// Position the other atoms of the cycle.
-		//writeShellOutput("demos/substrates/ADENOS10.xyz",processedMoc,0);
-		neighborStartPos = AX1E2(copyNewStartPos, coords(atom(moc, idStart)), normal, SIMPLE_CYCLE); // Neighbor
-		//writeShellOutput("demos/substrates/ADENOS10.xyz",processedMoc,0);
-		copyNewStartPos = AX2E1(copyNewStartPos, coords(atom(moc, idStart)), neighborStartPos, SIMPLE_CYCLE); 
-		//writeShellOutput("demos/substrates/ADENOS10.xyz",processedMoc,0);
-		if (isHindered(moc, sub, copyNewStartPos)) {
-			SHL_delete(moc);
-			return;
-		}
-
-		idAtomCycle = SHL_addAtom(moc, copyNewStartPos, -1);
-		flag(atom(moc, idAtomCycle)) = CARBON_F;
-		SHL_addEdge(moc, idnewStart, idAtomCycle);
-			
-		int idNeighbor = idAtomCycle;
-		for (int i = 0; i < 4; i++) {
-			neighborStartPos = coords(atom(moc, neighbor(atom(moc, idNeighbor), 0)));
-			copyNewStartPos = AX1E2(copyNewStartPos, neighborStartPos, normal, SIMPLE_CYCLE);
-			if (isHindered(moc, sub, copyNewStartPos)) {
-				SHL_delete(moc);
+		Point_t normal = planNormal(newStartPos, startPos, neighborStartPos);
+		normal = rotation(normalization(vector(newStartPos, startPos), 1),  90, normal); // Perpendicular
+		Point_t side = planNormal(zero, normal, bond); // Direction in the plane of the ring.
+
+		// Position the atoms of the cycle and the atom after it.
+		for (int k = 0; k < NB_ATOMS_IN_CYCLE - 1; k++) {
+			float a = ringTemplate[k][0] * SIMPLE_CYCLE, b = ringTemplate[k][1] * SIMPLE_CYCLE;
+			positions[k].x = newStartPos.x + a * bond.x + b * side.x;
+			positions[k].y = newStartPos.y + a * bond.y + b * side.y;
+			positions[k].z = newStartPos.z + a * bond.z + b * side.z;
+		}
+		positions[NB_ATOMS_IN_CYCLE - 1] = addPoint(positions[RING_EXIT], normalization(bond, DIST_SIMPLE));
+
+		// The first atom is already tested, and the atoms of the ring are far enough from each other.
+		for (int k = 1; k < NB_ATOMS_IN_CYCLE; k++) {
+			if (isHindered(processedMoc, sub, positions[k]))
 				return;
-			}
-			idAtomCycle = SHL_addAtom(moc, copyNewStartPos, -1);
-			flag(atom(moc, idAtomCycle)) = CARBON_F;
-			SHL_addEdge(moc, idNeighbor, idAtomCycle);
-				
-			if (i == 1) {// Position the next starting atom to continue the path.
-				nextPos = copyNewStartPos;
-				idNext = idAtomCycle;
-			}
-			idNeighbor = idAtomCycle;
 		}
 
-		SHL_addEdge(moc, idnewStart, idAtomCycle);
-			
-		// Position atom after the cycle.
-		neighborStartPos = coords(atom(moc, neighbor(atom(moc, idNext), 0)));
-		Point_t v2 = coords(atom(moc, neighbor(atom(moc, idNext), 1)));
-		copyNewStartPos = AX2E1(nextPos, neighborStartPos, v2, DIST_SIMPLE); 
-		if (isHindered(moc, sub, copyNewStartPos) == 1) {
-			SHL_delete(moc);
-			return;
-		}
-		int idSuiv2 = SHL_addAtom(moc, copyNewStartPos, -1);
-		flag(atom(moc, idSuiv2)) = CARBON_F;
-		SHL_addEdge(moc, idNext, idSuiv2);
+		ids[0] = TRL_addAtom(trail, processedMoc, positions[0], CARBON_F);
+		TRL_addEdge(trail, processedMoc, idStart, ids[0]);
+		for (int k = 1; k < NB_ATOMS_IN_CYCLE - 1; k++) {
+			ids[k] = TRL_addAtom(trail, processedMoc, positions[k], CARBON_F);
+			TRL_addEdge(trail, processedMoc, ids[k-1], ids[k]);
+		}
+		TRL_addEdge(trail, processedMoc, ids[0], ids[NB_ATOMS_IN_CYCLE - 2]);
+		ids[NB_ATOMS_IN_CYCLE - 1] = TRL_addAtom(trail, processedMoc, positions[NB_ATOMS_IN_CYCLE - 1], CARBON_F);
+		TRL_addEdge(trail, processedMoc, ids[RING_EXIT], ids[NB_ATOMS_IN_CYCLE - 1]);
 			
-		LSTm_addElement(mocsInProgress, moc);
-		LSTd_addElement(newStarts, idSuiv2);
+		LSTr_addElement(moves, TRL_copy(trail, mark));
+		LSTd_addElement(newStarts, ids[NB_ATOMS_IN_CYCLE - 1]);
+		TRL_undo(trail, processedMoc, mark);
 	}
 }
 
@@ -139,22 +164,22 @@ void addAromaticRing(Shell_t* processedMoc, List_m* mocsInProgress, int idStart,
  * @brief Adds the oxygen atom of a carbonyl pattern (pattern 3).
  * 
  * @param processedMoc Molecular cage being generated.
+ * @param trail Trail of the modifications of the cage.
  * @param idStart Index of the first linkable atom in the path in construction.
  * @param sub Substrate molecule.
- * @return (List_m*) List of cages in construction with the added oxygen.
+ * @return (List_r*) Stack of moves adding the oxygen.
  */
-List_m* addOxygenOfCarbonyl(Shell_t* processedMoc, int idStart, Molecule_t* sub) {
-	List_m* mocsInProgress = LSTm_init();
+List_r* addOxygenOfCarbonyl(Shell_t* processedMoc, Trail_t* trail, int idStart, Molecule_t* sub) {
+	List_r* moves = LSTr_init();
 	Point_t startPos = coords(atom(processedMoc, idStart));
 	int idNeighbor1 = neighbor(atom(processedMoc, idStart), 0); // Neighbor
 	Point_t neighbor1Pos = coords(atom(processedMoc, idNeighbor1));
 	
 	for (int i = 0; forEachNeighbor(atom(processedMoc,idNeighbor1), i); i++) { // For every possible plans with starting atom's neighbors.
 		if (neighbor(atom(processedMoc, idNeighbor1), i) != idStart) {
-			Shell_t* firstMoc = SHL_copy(processedMoc);
-			Shell_t* secondMoc = SHL_copy(processedMoc);
+			unsigned mark = nbChanges(trail);
 			
-			Point_t neighbor2Pos = coords(atom(firstMoc, neighbor(atom(firstMoc, idNeighbor1), i)));
+			Point_t neighbor2Pos = coords(atom(processedMoc, neighbor(atom(processedMoc, idNeighbor1), i)));
 						
 			// Look for the normal to position the oxygen.
 			Point_t normal = planNormal(startPos, neighbor1Pos, neighbor2Pos);
@@ -164,60 +189,45 @@ List_m* addOxygenOfCarbonyl(Shell_t* processedMoc, int idStart, Molecule_t* sub)
 			Point_t oxygenPos = AX1E2(startPos, neighbor1Pos, normal, DIST_SIMPLE);
 			int idOxygen;
 			
-			if (!isHindered(firstMoc, sub, oxygenPos)) {
-				idOxygen = SHL_addAtom(firstMoc, oxygenPos, -1);
-				flag(atom(firstMoc, idOxygen)) = OXYGEN_F;
-				SHL_addEdge(firstMoc, idStart, idOxygen);
+			if (!isHindered(processedMoc, sub, oxygenPos)) {
+				idOxygen = TRL_addAtom(trail, processedMoc, oxygenPos, OXYGEN_F);
+				TRL_addEdge(trail, processedMoc, idStart, idOxygen);
 				
-				LSTm_addElement(mocsInProgress, firstMoc);
-			}
-			else {
-				SHL_delete(firstMoc);
+				LSTr_addElement(moves, TRL_copy(trail, mark));
+				TRL_undo(trail, processedMoc, mark);
 			}
 						
 			// Second position
 			oxygenPos = AX2E1(startPos, neighbor1Pos, oxygenPos, DIST_SIMPLE);
 			
-			if (!isHindered(secondMoc, sub, oxygenPos)) {
-				int idOxygen = SHL_addAtom(secondMoc, oxygenPos, -1);
-				flag(atom(secondMoc, idOxygen)) = OXYGEN_F;
-				SHL_addEdge(secondMoc, idStart, idOxygen);	
-				LSTm_addElement(mocsInProgress, secondMoc);
-			}
-			else {
-				SHL_delete(secondMoc);
+			if (!isHindered(processedMoc, sub, oxygenPos)) {
+				int idOxygen = TRL_addAtom(trail, processedMoc, oxygenPos, OXYGEN_F);
+				TRL_addEdge(trail, processedMoc, idStart, idOxygen);	
+				LSTr_addElement(moves, TRL_copy(trail, mark));
+				TRL_undo(trail, processedMoc, mark);
 			}
 		}
 	}
-	return mocsInProgress;
+	return moves;
 }
 
 /**
  * @brief Adds a carbonyl pattern (c=0) and a neighboring atom.
  * 
  * @param processedMoc Molecular cage being generated.
- * @param mocsInProgress List of cages in construction to be processed.
+ * @param trail Trail of the modifications of the cage.
+ * @param moves Stack of moves (additions) to be processed.
  * @param idStart Index of the first linkable atom in the path in construction.
  * @param newStarts Stack of atoms starting a path in construction.
  * @param newStartPos Position (point) of the next atom added in the path.
  * @param sub Substrate molecule.
  */
-void addCarbonyl(Shell_t* processedMoc, List_m* mocsInProgress, int idStart, List_d* newStarts, Point_t newStartPos, Molecule_t* sub) {
+void addCarbonyl(Shell_t* processedMoc, Trail_t* trail, List_r* moves, int idStart, List_d* newStarts, Point_t newStartPos, Molecule_t* sub) {
 	for (int i = 0; forEachNeighbor(atom(processedMoc,idStart), i); i++) { // For every possible plans with starting atom's neighbors.
-		Shell_t* firstMoc = SHL_copy(processedMoc);
-		Shell_t* secondMoc = SHL_copy(processedMoc);
+		unsigned mark = nbChanges(trail);
 			
-		Point_t neighbor1Pos = coords(atom(firstMoc, neighbor(atom(firstMoc, idStart), i)));
-		Point_t startPos = coords(atom(firstMoc, idStart));
-			
-		// Carbon
-		int idNewStartMoc1 = SHL_addAtom(firstMoc, newStartPos, -1);
-		flag(atom(firstMoc, idNewStartMoc1)) = CARBON_F;
-		SHL_addEdge(firstMoc, idStart, idNewStartMoc1);
-		
-		int idNewStartMoc2 = SHL_addAtom(secondMoc, newStartPos, -1);
-		flag(atom(secondMoc, idNewStartMoc2)) = CARBON_F;
-		SHL_addEdge(secondMoc, idStart, idNewStartMoc2);
+		Point_t neighbor1Pos = coords(atom(processedMoc, neighbor(atom(processedMoc, idStart), i)));
+		Point_t startPos = coords(atom(processedMoc, idStart));
 			
 		// Look for the normal to position the oxygen.
 		Point_t normal = planNormal(newStartPos, startPos, neighbor1Pos);
@@ -226,64 +236,67 @@ void addCarbonyl(Shell_t* processedMoc, List_m* mocsInProgress, int idStart, Lis
 		// First position.
 		Point_t oxygenPos = AX1E2(newStartPos, startPos, normal, DIST_SIMPLE);
 		int idOxygen;
+
+		// Carbon
+		int idNewStart = TRL_addAtom(trail, processedMoc, newStartPos, CARBON_F);
+		TRL_addEdge(trail, processedMoc, idStart, idNewStart);
 			
-		if (!isHindered(firstMoc, sub, oxygenPos)) {
-			int idOxygen = SHL_addAtom(firstMoc, oxygenPos, -1);
-			flag(atom(firstMoc, idOxygen)) = OXYGEN_F;
-			SHL_addEdge(firstMoc, idNewStartMoc1, idOxygen);
+		if (!isHindered(processedMoc, sub, oxygenPos)) {
+			int idOxygen = TRL_addAtom(trail, processedMoc, oxygenPos, OXYGEN_F);
+			TRL_addEdge(trail, processedMoc, idNewStart, idOxygen);
 				
-			LSTm_addElement(mocsInProgress, firstMoc);
-			LSTd_addElement(newStarts, idNewStartMoc1);
-		}
-		else {
-			SHL_delete(firstMoc);
+			LSTr_addElement(moves, TRL_copy(trail, mark));
+			LSTd_addElement(newStarts, idNewStart);
 		}
+		TRL_undo(trail, processedMoc, mark);
 			
 		// Second position.
 		oxygenPos = AX2E1(newStartPos, startPos, oxygenPos, DIST_SIMPLE);
+
+		idNewStart = TRL_addAtom(trail, processedMoc, newStartPos, CARBON_F);
+		TRL_addEdge(trail, processedMoc, idStart, idNewStart);
 			
-		if (!isHindered(secondMoc, sub, oxygenPos)) {
-			idOxygen = SHL_addAtom(secondMoc, oxygenPos, -1);
-			flag(atom(secondMoc, idOxygen)) = OXYGEN_F;
-			SHL_addEdge(secondMoc, idNewStartMoc2, idOxygen);
+		if (!isHindered(processedMoc, sub, oxygenPos)) {
+			idOxygen = TRL_addAtom(trail, processedMoc, oxygenPos, OXYGEN_F);
+			TRL_addEdge(trail, processedMoc, idNewStart, idOxygen);
 				
-			LSTm_addElement(mocsInProgress, secondMoc);
-			LSTd_addElement(newStarts, idNewStartMoc2);
+			LSTr_addElement(moves, TRL_copy(trail, mark));
+			LSTd_addElement(newStarts, idNewStart);
 		}
-		else {
-			SHL_delete(secondMoc);
-		}		
+		TRL_undo(trail, processedMoc, mark);
 	}
 }
 
 /**
  * @brief Adds the projected atom(s) to the cage being generated.
+ * Each addition is recorded as a move (the cage is left unchanged).
  * 
  * @param processedMoc Molecular cage being generated.
- * @param mocsInProgress List of cages in construction to be processed.
+ * @param trail Trail of the modifications of the cage.
+ * @param moves Stack of moves (additions) to be processed.
  * @param idStart Index of the first linkable atom in the path in construction.
  * @param newStarts Stack of atoms starting a path in construction.
  * @param numPattern Pattern number (0, 1, 2) in the main loop. 
  * @param newStartPos Position (point) of the next atom added in the path.
  * @param sub Substrate molecule.
  */
-void addProjection(Shell_t* processedMoc, List_m* mocsInProgress, int idStart, List_d* newStarts, int numPattern, Point_t newStartPos, Molecule_t* sub) {
+void addProjection(Shell_t* processedMoc, Trail_t* trail, List_r* moves, int idStart, List_d* newStarts, int numPattern, Point_t newStartPos, Molecule_t* sub) {
 	
 	if (numPattern == 3) {
-		addCarbonyl(processedMoc, mocsInProgress, idStart, newStarts, newStartPos, sub);
+		addCarbonyl(processedMoc, trail, moves, idStart, newStarts, newStartPos, sub);
 	}
 	else if (numPattern == 4) {
-		addAromaticRing(processedMoc, mocsInProgress, idStart, newStarts, newStartPos, sub);
+		addAromaticRing(processedMoc, trail, moves, idStart, newStarts, newStartPos, sub);
 	}
 	else {
-		Shell_t* moc = SHL_copy(processedMoc);
+		unsigned mark = nbChanges(trail);
 	
-		int idnewStart = SHL_addAtom(moc, newStartPos, -1);
-		flag(atom(moc, idnewStart)) = insertType(numPattern);
-		SHL_addEdge(moc, idStart, idnewStart);
+		int idnewStart = TRL_addAtom(trail, processedMoc, newStartPos, insertType(numPattern));
+		TRL_addEdge(trail, processedMoc, idStart, idnewStart);
 		
-		LSTm_addElement(mocsInProgress, moc);
+		LSTr_addElement(moves, TRL_copy(trail, mark));
 		LSTd_addElement(newStarts, idnewStart);
+		TRL_undo(trail, processedMoc, mark);
 	}
 }
 
@@ -292,7 +305,7 @@ void addProjection(Shell_t* processedMoc, List_m* mocsInProgress, int idStart, L
 /**************************************/
 
 // Projection for an atom with one neighbor.
-void projectionOCN_AX1E3(Shell_t* processedMoc, List_m* mocsInsProgress, int idStart, int idEnd, List_d* newStarts, int numPattern, Molecule_t* sub) {
+void projectionOCN_AX1E3(Shell_t* processedMoc, Trail_t* trail, List_r* moves, int idStart, int idEnd, List_d* newStarts, int numPattern, Molecule_t* sub) {
 	
 	List_s* positions = LSTs_init();
 	Point_t startPos = coords(atom(processedMoc, idStart));
@@ -325,55 +338,55 @@ void projectionOCN_AX1E3(Shell_t* processedMoc, List_m* mocsInsProgress, int idS
 	for (int i = 0; i < NUMBER_POSITION_AX1E3 && positions->first; i++) { // Best placed position (min distance to the end)
 		newStartPos = minDist(positions, endPos); 
 		LSTs_removeElement(positions, newStartPos);
-		addProjection(processedMoc, mocsInsProgress, idStart, newStarts, numPattern, newStartPos, sub);
+		addProjection(processedMoc, trail, moves, idStart, newStarts, numPattern, newStartPos, sub);
 	}
 	LSTs_delete(positions);
 }
 
 // Projection for a nitrogen with two neighbors.
-void projectionN_AX2E2(Shell_t* processedMoc, List_m* mocsInProgress, int idStart, List_d* newStarts, int numPattern, Molecule_t* sub) {
+void projectionN_AX2E2(Shell_t* processedMoc, Trail_t* trail, List_r* moves, int idStart, List_d* newStarts, int numPattern, Molecule_t* sub) {
 	
 	int idFirstNeighbor = neighbor(atom(processedMoc, idStart), 0);
 	int idSecondNeighbor = neighbor(atom(processedMoc, idStart), 1);
 	Point_t newStartPos = AX2E2(coords(atom(processedMoc, idStart)), coords(atom(processedMoc, idFirstNeighbor)), coords(atom(processedMoc, idSecondNeighbor)), DIST_SIMPLE);
 	
 	if (!isHindered(processedMoc, sub, newStartPos)) {
-		addProjection(processedMoc, mocsInProgress, idStart, newStarts, numPattern, newStartPos, sub);
+		addProjection(processedMoc, trail, moves, idStart, newStarts, numPattern, newStartPos, sub);
 	}
 }
 
 // Projection for a carbon with two neighbors and one is an oxygen.
-void projectionC_AX2E1(Shell_t* processedMoc, List_m* mocsInProgress, int idStart, List_d* newStarts, int numPattern, Molecule_t* sub) {
+void projectionC_AX2E1(Shell_t* processedMoc, Trail_t* trail, List_r* moves, int idStart, List_d* newStarts, int numPattern, Molecule_t* sub) {
 	
 	int idFirstNeighbor = neighbor(atom(processedMoc, idStart), 0);
 	int idSecondNeighbor = neighbor(atom(processedMoc, idStart), 1);
 	Point_t newStartPos = AX2E1(coords(atom(processedMoc, idStart)), coords(atom(processedMoc, idFirstNeighbor)), coords(atom(processedMoc, idSecondNeighbor)), DIST_SIMPLE);
 	
 	if (!isHindered(processedMoc, sub, newStartPos)) {
-		addProjection(processedMoc, mocsInProgress, idStart, newStarts, numPattern, newStartPos, sub);
+		addProjection(processedMoc, trail, moves, idStart, newStarts, numPattern, newStartPos, sub);
 	}
 }
 
 // Projection for a carbon with two neighbors.
-void projectionC_AX2E2(Shell_t* processedMoc, List_m* mocsInProgress, int idStart, List_d* newStarts, int numPattern, Molecule_t* sub) {
+void projectionC_AX2E2(Shell_t* processedMoc, Trail_t* trail, List_r* moves, int idStart, List_d* newStarts, int numPattern, Molecule_t* sub) {
 	
 	int idFirstNeighbor = neighbor(atom(processedMoc, idStart), 0);
 	int idSecondNeighbor = neighbor(atom(processedMoc, idStart), 1);
 	Point_t newStartPos = AX2E2(coords(atom(processedMoc, idStart)), coords(atom(processedMoc, idFirstNeighbor)), coords(atom(processedMoc, idSecondNeighbor)), DIST_SIMPLE);
 	
 	if (!isHindered(processedMoc, sub, newStartPos)) {
-		addProjection(processedMoc, mocsInProgress, idStart, newStarts, numPattern, newStartPos, sub);
+		addProjection(processedMoc, trail, moves, idStart, newStarts, numPattern, newStartPos, sub);
 	}
 	
 	Point_t newStartPos2 = AX3E1(coords(atom(processedMoc, idStart)), coords(atom(processedMoc, idFirstNeighbor)), coords(atom(processedMoc, idSecondNeighbor)), newStartPos, DIST_SIMPLE);
 	
 	if (!isHindered(processedMoc, sub, newStartPos2) == 0) {
-		addProjection(processedMoc, mocsInProgress, idStart, newStarts, numPattern, newStartPos2, sub);
+		addProjection(processedMoc, trail, moves, idStart, newStarts, numPattern, newStartPos2, sub);
 	}
 }
 
 // Projection for a carbone with 3 neighbors.
-void projectionC_AX3E1(Shell_t* processedMoc, List_m* mocsInProgress, int idStart, List_d* newStarts, int numPattern,Molecule_t* sub) {
+void projectionC_AX3E1(Shell_t* processedMoc, Trail_t* trail, List_r* moves, int idStart, List_d* newStarts, int numPattern,Molecule_t* sub) {
 	
 	int idFirstNeighbor = neighbor(atom(processedMoc, idStart), 0);
 	int idSecondNeighbor = neighbor(atom(processedMoc, idStart), 1);
@@ -381,7 +394,7 @@ void projectionC_AX3E1(Shell_t* processedMoc, List_m* mocsInProgress, int idStar
 	Point_t newStartPos = AX3E1(coords(atom(processedMoc, idStart)), coords(atom(processedMoc, idFirstNeighbor)), coords(atom(processedMoc, idSecondNeighbor)), coords(atom(processedMoc, idThirdNeighbor)), DIST_SIMPLE);
 	
 	if (!isHindered(processedMoc, sub, newStartPos)) {
-		addProjection(processedMoc, mocsInProgress, idStart, newStarts, numPattern, newStartPos, sub);
+		addProjection(processedMoc, trail, moves, idStart, newStarts, numPattern, newStartPos, sub);
 	}
 }
 
@@ -391,26 +404,28 @@ void projectionC_AX3E1(Shell_t* processedMoc, List_m* mocsInProgress, int idStar
 
 /**
  * @brief Inserts the inputted pattern in a path.
+ * The insertions are recorded as moves and the cage is left unchanged.
  * 
  * @param processedMoc Molecular cage being generated.
- * @param mocsInProgress List of cages in construction to be processed.
+ * @param trail Trail of the modifications of the cage.
+ * @param moves Stack of moves (insertions) to be processed.
  * @param idStart Index of the first linkable atom in the path in construction.
  * @param newStarts Stack of atoms starting a path in construction.
  * @param numPattern Pattern number (0, 1, 2) in the main loop. 
  * @param idEnd Index of the atom the path in construction is to be connected to.
  * @param sub Substrate molecule.
  */
-void insertPattern(Shell_t* processedMoc, List_m* mocsInProgress, int idStart, List_d* newStarts, int numPattern, int idEnd, Molecule_t* sub){
+void insertPattern(Shell_t* processedMoc, Trail_t* trail, List_r* moves, int idStart, List_d* newStarts, int numPattern, int idEnd, Molecule_t* sub){
 	
 	int numberOfNeighborsStart = LST_nbElements(neighborhood(atom(processedMoc, idStart)));
 	if (numberOfNeighborsStart == 1) {
 		//Projections
 		//Diff rotations
-		projectionOCN_AX1E3(processedMoc, mocsInProgress, idStart, idEnd, newStarts, numPattern, sub);
+		projectionOCN_AX1E3(processedMoc, trail, moves, idStart, idEnd, newStarts, numPattern, sub);
 	}
 	else if (flag(atom(processedMoc, idStart)) == NITROGEN_F && numberOfNeighborsStart == 2) {
 		//Projection
-		projectionN_AX2E2(processedMoc, mocsInProgress, idStart, newStarts, numPattern, sub);
+		projectionN_AX2E2(processedMoc, trail, moves, idStart, newStarts, numPattern, sub);
 	}
 	else if (flag(atom(processedMoc, idStart)) == CARBON_F) {
 		if (numberOfNeighborsStart == 2) {
@@ -418,61 +433,212 @@ void insertPattern(Shell_t* processedMoc, List_m* mocsInProgress, int idStart, L
 			int idSecondNeighborStart = neighbor(atom(processedMoc, idStart), 1);
 			if (flag(atom(processedMoc, idFirstNeighborStart)) == OXYGEN_F || flag(atom(processedMoc, idSecondNeighborStart)) == OXYGEN_F) {
 				// Projection
-				projectionC_AX2E1(processedMoc, mocsInProgress, idStart, newStarts, numPattern, sub);
+				projectionC_AX2E1(processedMoc, trail, moves, idStart, newStarts, numPattern, sub);
 			}
 			else {
 				// 2 Projections
-				projectionC_AX2E2(processedMoc, mocsInProgress, idStart, newStarts, numPattern, sub);
+				projectionC_AX2E2(processedMoc, trail, moves, idStart, newStarts, numPattern, sub);
 			}
 		}
 		else { 
 			// 3 neighbors
 			//Projection
-			projectionC_AX3E1(processedMoc, mocsInProgress, idStart, newStarts, numPattern, sub);
+			projectionC_AX3E1(processedMoc, trail, moves, idStart, newStarts, numPattern, sub);
 		}
 	}
 }
 
+/**
+ * @brief Angle between the first neighbor of an atom, the atom and another atom.
+ * 
+ * @param processedMoc Molecular cage being generated.
+ * @param id Atom at the vertex of the angle.
+ * @param idOther Other atom.
+ * @return (float) Angle in degrees.
+ */
+float endAngle(Shell_t* processedMoc, int id, int idOther) {
+
+	float a = dist(coords(atom(processedMoc, id)), coords(atom(processedMoc, neighbor(atom(processedMoc, id), 0))));
+	float b = dist(coords(atom(processedMoc, id)), coords(atom(processedMoc, idOther)));
+	float c = dist(coords(atom(processedMoc, neighbor(atom(processedMoc, id), 0))), coords(atom(processedMoc, idOther)));
+
+	return radianToDegre(acosf(((c * c) - (a * a) - (b * b)) / (-2 * a * b)));
+}
+
+/**
+ * @brief Checks if the angles of the bond closing a path are close enough to END_ANGLE.
+ * 
+ * @param processedMoc Molecular cage being generated.
+ * @param idLast Last atom of the path.
+ * @param idEnd Atom the path is to be connected to.
+ * @return (int) 1 if the path can be closed, 0 otherwise.
+ */
+int checkEndAngles(Shell_t* processedMoc, int idLast, int idEnd) {
+
+	float beforeLastAngle = endAngle(processedMoc, idLast, idEnd);
+	float lastAngle = endAngle(processedMoc, idEnd, idLast);
+
+	return beforeLastAngle >= (END_ANGLE - ANGLE_ERROR) && beforeLastAngle <= (END_ANGLE + ANGLE_ERROR) && lastAngle <= (END_ANGLE + ANGLE_ERROR) && lastAngle >= (END_ANGLE - ANGLE_ERROR);
+}
+
+/**
+ * @brief Lower bound of the number of atoms still to be added to a path to reach its end atom.
+ * A path advances at most DIST_PATH_STEP per atom (DIST_SIMPLE for a single atom)
+ * and is closed when its last atom is closer than DIST_SIMPLE + DIST_ERROR to the end atom.
+ * 
+ * @param distance Distance between the last atom of the path and the end atom.
+ * @return (int) Minimal number of atoms to add (at least 1).
+ */
+int minAtomsToEnd(float distance) {
+
+	float remaining = distance - (DIST_SIMPLE + DIST_ERROR) - (DIST_SIMPLE - DIST_PATH_STEP);
+
+	if (remaining <= 0)
+		return 1;
+	return (int)ceilf(remaining / DIST_PATH_STEP);
+}
+
+/**
+ * @brief Stops the search of the cages (for all the threads).
+ * 
+ * @param m Grouping of the main structures (substrate and envelope).
+ * @param reason STOP_RESULTS, STOP_NODES or STOP_DEADLINE.
+ */
+void stopSearch(Main_t* m, int reason) {
+
+	#pragma omp atomic write
+	m->budget.stop = reason;
+}
+
+/**
+ * @brief Checks if the path search of a pair is over:
+ * the search of the cages is stopped or the budget of the pair is exhausted.
+ * 
+ * @param m Grouping of the main structures (substrate and envelope).
+ * @param nbPairNodes Number of nodes of the path search of the pair.
+ * @return (int) 1 if the path search must stop, 0 otherwise.
+ */
+int isSearchOver(Main_t* m, long* nbPairNodes) {
+
+	int stop;
+	long nbNodes;
+
+	#pragma omp atomic read
+	stop = m->budget.stop;
+	#pragma omp atomic read
+	nbNodes = *nbPairNodes;
+
+	return stop != STOP_NONE || (m->budget.maxPairNodes > 0 && nbNodes >= m->budget.maxPairNodes);
+}
+
+/**
+ * @brief Stops the search to write a checkpoint if SIGTERM was received
+ * (the path searches in progress are interrupted).
+ * 
+ * @param m Grouping of the main structures (substrate and envelope).
+ * @return (int) 1 if the search is stopped for a checkpoint, 0 otherwise.
+ */
+int isCheckpointSignaled(Main_t* m) {
+
+	int stop;
+
+	#pragma omp atomic read
+	stop = m->budget.stop;
+	if (stop == STOP_NONE && m->budget.checkpoint > 0 && checkpointSignal()) {
+		stopSearch(m, STOP_CHECKPOINT);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Counts a node of the path search and checks the budgets.
+ * The search of the cages is stopped when the deadline or the maximum number of nodes is reached.
+ * 
+ * @param m Grouping of the main structures (substrate and envelope).
+ * @param nbPairNodes Number of nodes of the path search of the pair.
+ * @return (int) 1 if the node must not be explored, 0 otherwise.
+ */
+int countNode(Main_t* m, long* nbPairNodes) {
+
+	long nbNodes;
+
+	if (isSearchOver(m, nbPairNodes))
+		return 1;
+
+	#pragma omp atomic
+	(*nbPairNodes)++;
+	#pragma omp atomic capture
+	nbNodes = ++m->budget.nbNodes;
+
+	if (m->budget.maxNodes > 0 && nbNodes > m->budget.maxNodes) {
+		stopSearch(m, STOP_NODES);
+		return 1;
+	}
+	if (m->budget.deadline > 0 && omp_get_wtime() > m->budget.deadline) {
+		stopSearch(m, STOP_DEADLINE);
+		return 1;
+	}
+	return isCheckpointSignaled(m);
+}
+
 /**
  * @brief Recursively generates paths between two grouping of bonding patterns.
+ * The paths are built in place in the cage: each move is replayed, explored and undone,
+ * and only the completed cages are copied in the list to be processed.
+ * Under the depth TASK_DEPTH, each move is explored in an OpenMP task on its own copy
+ * of the cage, with its own list of results. The lists are added to mocsInProgress 
+ * after the tasks, in the order of the sequential search.
  * 
  * @param m Grouping of the main structures (substrate and envelope).
  * @param mocsInProgress List of cages in construction to be processed.
  * @param processedMoc Molecular cage being generated.
+ * @param trail Trail of the modifications of the cage.
  * @param idStart Index of the first linkable atom in the path in construction.
  * @param idEnd Index of the atom the path in construction is to be connected to.
  * @param nbCarbonyls Number of consecutive carbonyl patterns autorized.
  * @param nbAroRings Number of aromatic rings recquiried.
- * @param inputFile Name of the substrate's file.
+ * @param inputFile Name of the results (substrate's name).
+ * @param sizeMin Minimale size (in atoms) of a closed path.
  * @param sizeMax Maximale size (in atoms) of a path.
  * @param startingMocSize Size (in atoms) of the cage before adding the path.
+ * @param forceCycle 1 if the path must contain an aromatic ring.
+ * @param depth Number of patterns already inserted in the path.
+ * @param nbPairNodes Number of nodes of the path search of the pair (shared by its tasks).
  */
-void generatePaths(Main_t* m, List_m* mocsInProgress, Shell_t* processedMoc, int idStart, int idEnd, int nbCarbonyls, int nbAroRings, char* inputFile, int sizeMax, int startingMocSize, int forceCycle) {
+void generatePaths(Main_t* m, List_m* mocsInProgress, Shell_t* processedMoc, Trail_t* trail, int idStart, int idEnd, int nbCarbonyls, int nbAroRings, char* inputFile, int sizeMin, int sizeMax, int startingMocSize, int forceCycle, int depth, long* nbPairNodes) {
+	/*************** Budgets of the search *************/
+	if (countNode(m, nbPairNodes))
+		return;
 	/*************** Check distances bewteen atoms *****/
-	Point_t B = coords(atom(processedMoc, idStart));
-	for (int i = 0; i < size(processedMoc); i++) {
-		if (i != idStart) {
-			Point_t A = coords(atom(processedMoc, i));
-			if (dist(A, B) < DIST_GAP_CAGE) {
-				return;
-			}
-		}
-	}
-	for (int i = 0; i < size(substrat(m)); i++){
-		Point_t A = coords(atom(substrat(m), i));
-		if (dist(A, B) < DIST_GAP_SUBSTRATE) {
-			return;
-		}
-	}
+	if (isHinderedExcept(processedMoc, substrat(m), coords(atom(processedMoc, idStart)), idStart))
+		return;
 	/***************************************************/
+	List_m** results = NULL; // Results of each move (only when its exploration is a task).
+	int nbResults = 0;
+	int tasks = 0;
+#ifdef _OPENMP
+	tasks = (depth < TASK_DEPTH && omp_get_num_threads() > 1);
+#endif
+
 	for (int i = 2; i < NB_PATTERNS; i++) {
 		if(i == 3) i++; // TEMP exclude carbonyl pattern
-		List_m* tempMocsInProg = LSTm_init();
+		List_r* moves = LSTr_init();
 		List_d* newStarts = LSTd_init();
 		
-		insertPattern(processedMoc, tempMocsInProg, idStart, newStarts, i, idEnd, substrat(m));
+		insertPattern(processedMoc, trail, moves, idStart, newStarts, i, idEnd, substrat(m));
 		
-		while (tempMocsInProg->first) {
+		while (moves->first && !isSearchOver(m, nbPairNodes)) {
+			unsigned mark = nbChanges(trail);
+			TRL_replay(trail, processedMoc, moves->first->move);
+
+			List_m* resultsMove = mocsInProgress;
+			if (tasks) {
+				resultsMove = LSTm_init();
+				results = realloc(results, (nbResults+1)*sizeof(List_m*));
+				results[nbResults++] = resultsMove;
+			}
+
 			// Count the number of consecutive carbonyls.
 			if (i == 3) {
 				nbCarbonyls++;
@@ -486,111 +652,487 @@ void generatePaths(Main_t* m, List_m* mocsInProgress, Shell_t* processedMoc, int
 				nbAroRings++;
 			}
 			
-			if(sizeMax >= SHL_nbAtom(tempMocsInProg->first->moc) - startingMocSize) {
-				if (dist( coords(atom(tempMocsInProg->first->moc, newStarts->first->idAtom)), coords(atom(processedMoc, idEnd)) ) < DIST_SIMPLE + DIST_ERROR) {
-					float trA = dist( coords(atom(tempMocsInProg->first->moc, newStarts->first->idAtom)), coords(atom(tempMocsInProg->first->moc,neighbor(atom(tempMocsInProg->first->moc, newStarts->first->idAtom),0))));
-					float trB = dist( coords(atom(tempMocsInProg->first->moc, newStarts->first->idAtom)), coords(atom(tempMocsInProg->first->moc, idEnd)));
-					float trC = dist(coords(atom(tempMocsInProg->first->moc,neighbor(atom(tempMocsInProg->first->moc, newStarts->first->idAtom),0))), coords(atom(tempMocsInProg->first->moc, idEnd)));
-					float trD = dist( coords(atom(tempMocsInProg->first->moc, idEnd)), coords(atom(tempMocsInProg->first->moc,neighbor(atom(tempMocsInProg->first->moc, idEnd),0))));
-					float trE = dist(coords(atom(tempMocsInProg->first->moc,neighbor(atom(tempMocsInProg->first->moc, idEnd),0))), coords(atom(tempMocsInProg->first->moc, newStarts->first->idAtom)));
-					float beforeLastAngle = radianToDegre(acosf(((trC * trC) - (trA * trA) - (trB * trB)) / (-2 * trA * trB)));
-					float lastAngle = radianToDegre(acosf(((trE * trE) - (trD * trD) - (trB * trB)) / (-2 * trD * trB)));
-
-					if(beforeLastAngle >= (END_ANGLE - ANGLE_ERROR) && beforeLastAngle <= (END_ANGLE + ANGLE_ERROR) && lastAngle <= (END_ANGLE + ANGLE_ERROR) && lastAngle >= (END_ANGLE - ANGLE_ERROR)) {
+			if(sizeMax >= SHL_nbAtom(processedMoc) - startingMocSize) {
+				if (dist( coords(atom(processedMoc, newStarts->first->idAtom)), coords(atom(processedMoc, idEnd)) ) < DIST_SIMPLE + DIST_ERROR) {
+					if (SHL_nbAtom(processedMoc) - startingMocSize >= sizeMin && checkEndAngles(processedMoc, newStarts->first->idAtom, idEnd)) {
 						if(!forceCycle || (forceCycle && nbAroRings > 0)) { // Only if there is a cycle in the path and we force the presence of a cycle.
-							flag(atom(tempMocsInProg->first->moc, idEnd)) = CARBON_F; // Change end atom (arrival) flag.
-							SHL_addEdge(tempMocsInProg->first->moc, newStarts->first->idAtom, idEnd); //Add a link between last atom of the path and arrival.
-							LSTm_addElement(mocsInProgress, SHL_copy(tempMocsInProg->first->moc));// Add to the list to be processed.
+							TRL_setFlag(trail, processedMoc, idEnd, CARBON_F); // Change end atom (arrival) flag.
+							TRL_addEdge(trail, processedMoc, newStarts->first->idAtom, idEnd); //Add a link between last atom of the path and arrival.
+							LSTm_addElement(resultsMove, SHL_copy(processedMoc));// Add to the list to be processed.
 						}
 					}
 				}
 				else if (nbCarbonyls < 5 && nbAroRings < 3) {
-					generatePaths(m, mocsInProgress, tempMocsInProg->first->moc, newStarts->first->idAtom, idEnd, nbCarbonyls, nbAroRings, inputFile, sizeMax, startingMocSize, forceCycle);
+					// Branch and bound: the path must still reach the end atom (and contain a ring) within sizeMax atoms.
+					int nbAtoms = SHL_nbAtom(processedMoc) - startingMocSize;
+					float endDist = dist(coords(atom(processedMoc, newStarts->first->idAtom)), coords(atom(processedMoc, idEnd)));
+					
+					if (nbAtoms + minAtomsToEnd(endDist) > sizeMax) {
+						#pragma omp atomic
+						m->budget.nbPrunedDistance++;
+					}
+					else if (forceCycle && nbAroRings == 0 && nbAtoms + NB_ATOMS_IN_CYCLE > sizeMax) {
+						#pragma omp atomic
+						m->budget.nbPrunedCycle++;
+					}
+					else if (tasks) {
+						Shell_t* taskMoc = SHL_copy(processedMoc);
+						int idNewStart = newStarts->first->idAtom;
+
+						#pragma omp task firstprivate(resultsMove, taskMoc, idNewStart, nbCarbonyls, nbAroRings)
+						{
+							Trail_t* taskTrail = TRL_create();
+							generatePaths(m, resultsMove, taskMoc, taskTrail, idNewStart, idEnd, nbCarbonyls, nbAroRings, inputFile, sizeMin, sizeMax, startingMocSize, forceCycle, depth+1, nbPairNodes);
+							TRL_delete(taskTrail);
+							SHL_delete(taskMoc);
+						}
+					}
+					else {
+						generatePaths(m, mocsInProgress, processedMoc, trail, newStarts->first->idAtom, idEnd, nbCarbonyls, nbAroRings, inputFile, sizeMin, sizeMax, startingMocSize, forceCycle, depth+1, nbPairNodes);
+					}
 				}
 			}
-			LSTm_removeFirst(tempMocsInProg);
+			TRL_undo(trail, processedMoc, mark);
+			LSTr_removeFirst(moves);
 			LSTd_removeFirst(newStarts);
 		}
-		LSTm_delete(tempMocsInProg);
+		LSTr_delete(moves);
 		LSTd_delete(newStarts);
 	}
-}
 
-/*************************************************/
-/******* Start and end atoms of the paths ********/
-/*************************************************/
+	if (results != NULL) {
+		#pragma omp taskwait
+		for (int i = 0; i < nbResults; i++)
+			LSTm_addList(mocsInProgress, results[i]);
+		free(results);
+	}
+}
 
 /**
- * @brief Recursively does a depth-first search.
+ * @brief Generates paths between two grouping of bonding patterns by iterative deepening.
+ * The paths are closed by increasing size: the partial paths are kept by size (as the changes
+ * of the cage since the start of the search) and those of each size are expanded once,
+ * when the limit reaches it, instead of searching again from the start atom at each limit.
+ * Once the partial paths of less than size atoms are expanded, the paths of size atoms are all closed.
+ * The deepening stops once maxResults paths are found, and the shortest paths are processed first.
  * 
- * @param s Cage without any added paths.
- * @param markedAtoms List of previously visited atoms.
- * @param index1 Starting atom index.
- * @param index2 Searched atom index.
- * @return (int) 1 if the searched atom is found, 0 otherwise. 
- */
-int search(Shell_t* s, List_t* markedAtoms, int index1, int index2) {
-	AtomShl_t* a = atom(s, index1);
-	LST_addElement(markedAtoms, index1);
-	
-	if (neighborhoodSize(a) == 0) {
-		return 0;
+ * @param m Grouping of the main structures (substrate and envelope).
+ * @param mocsInProgress List of cages in construction to be processed.
+ * @param processedMoc Molecular cage being generated.
+ * @param trail Trail of the modifications of the cage.
+ * @param idStart Index of the first linkable atom in the path in construction.
+ * @param idEnd Index of the atom the path in construction is to be connected to.
+ * @param inputFile Name of the results (substrate's name).
+ * @param sizeMax Maximale size (in atoms) of a path.
+ * @param maxResults Number of paths after which the deepening stops.
+ * @param startingMocSize Size (in atoms) of the cage before adding the path.
+ * @param forceCycle 1 if the path must contain an aromatic ring.
+ * @param nbPairNodes Number of nodes of the path search of the pair.
+ */
+void deepeningPaths(Main_t* m, List_m* mocsInProgress, Shell_t* processedMoc, Trail_t* trail, int idStart, int idEnd, char* inputFile, int sizeMax, int maxResults, int startingMocSize, int forceCycle, long* nbPairNodes) {
+
+	unsigned base = nbChanges(trail);
+	List_m** levels = malloc((sizeMax+1)*sizeof(List_m*)); // Paths of each size.
+	State_t*** partials = malloc((sizeMax+1)*sizeof(State_t**)); // Partial paths of each size.
+	int* nbPartials = calloc(sizeMax+1, sizeof(int));
+	int nbPaths = 0, size, i;
+
+	for (size = 0; size <= sizeMax; size++) {
+		levels[size] = LSTm_init();
+		partials[size] = NULL;
 	}
-	else {
-		for (int i = 0; i < neighborhoodSize(a); i++) {
+	partials[0] = malloc(sizeof(State_t*));
+	partials[0][nbPartials[0]++] = STA_create(TRL_create(), idStart, 0, 0, 0);
 
-			if (neighbor(a, i) == index2) {
-				return 1;
+	for (size = 1; size <= sizeMax && nbPaths < maxResults && !isSearchOver(m, nbPairNodes); size++) {
+		for (i = 0; i < nbPartials[size-1] && !countNode(m, nbPairNodes); i++) {
+			State_t* state = partials[size-1][i];
+			int nbCarbonyls = state->nbCarbonyls, nbAroRings = state->nbAroRings;
+
+			TRL_replay(trail, processedMoc, state->path);
+			if (isHinderedExcept(processedMoc, substrat(m), coords(atom(processedMoc, state->idStart)), state->idStart)) {
+				TRL_undo(trail, processedMoc, base);
+				continue;
 			}
-			else {
-				if (!LST_check(markedAtoms, neighbor(a, i))) {
-					if (search(s, markedAtoms, neighbor(a, i), index2)) {
-						return 1;
+			for (int j = 2; j < NB_PATTERNS; j++) {
+				if(j == 3) j++; // TEMP exclude carbonyl pattern
+				List_r* moves = LSTr_init();
+				List_d* newStarts = LSTd_init();
+				
+				insertPattern(processedMoc, trail, moves, state->idStart, newStarts, j, idEnd, substrat(m));
+				
+				while (moves->first) {
+					unsigned mark = nbChanges(trail);
+					int idNewStart = newStarts->first->idAtom;
+					TRL_replay(trail, processedMoc, moves->first->move);
+					int nbAtoms = SHL_nbAtom(processedMoc) - startingMocSize;
+
+					// The counters are those of generatePaths.
+					nbCarbonyls = (j == 3) ? nbCarbonyls + 1 : 0;
+					if (j == 4)
+						nbAroRings++;
+					
+					if (sizeMax >= nbAtoms) {
+						float endDist = dist(coords(atom(processedMoc, idNewStart)), coords(atom(processedMoc, idEnd)));
+						
+						if (endDist < DIST_SIMPLE + DIST_ERROR) {
+							if (checkEndAngles(processedMoc, idNewStart, idEnd) && (!forceCycle || nbAroRings > 0)) {
+								TRL_setFlag(trail, processedMoc, idEnd, CARBON_F); // Change end atom (arrival) flag.
+								TRL_addEdge(trail, processedMoc, idNewStart, idEnd); //Add a link between last atom of the path and arrival.
+								LSTm_addElement(levels[nbAtoms], SHL_copy(processedMoc));
+							}
+						}
+						else if (nbCarbonyls < 5 && nbAroRings < 3) {
+							if (nbAtoms + minAtomsToEnd(endDist) > sizeMax) {
+								#pragma omp atomic
+								m->budget.nbPrunedDistance++;
+							}
+							else if (forceCycle && nbAroRings == 0 && nbAtoms + NB_ATOMS_IN_CYCLE > sizeMax) {
+								#pragma omp atomic
+								m->budget.nbPrunedCycle++;
+							}
+							else { // Expanded when the limit reaches its size.
+								partials[nbAtoms] = realloc(partials[nbAtoms], (nbPartials[nbAtoms]+1)*sizeof(State_t*));
+								partials[nbAtoms][nbPartials[nbAtoms]++] = STA_create(TRL_copy(trail, base), idNewStart, nbCarbonyls, nbAroRings, 0);
+							}
+						}
 					}
+					TRL_undo(trail, processedMoc, mark);
+					LSTr_removeFirst(moves);
+					LSTd_removeFirst(newStarts);
 				}
+				LSTr_delete(moves);
+				LSTd_delete(newStarts);
 			}
+			TRL_undo(trail, processedMoc, base);
 		}
+		for (i = 0; i < nbPartials[size-1]; i++) // Expanded (or left by the budgets).
+			STA_delete(partials[size-1][i]);
+		nbPartials[size-1] = 0;
+		for (Elem* e = levels[size]->first; e; e = e->next)
+			nbPaths++;
 	}
-	return 0;
+
+	for (i = sizeMax; i >= 0; i--) { // The shortest paths at the head of the list.
+		if (i < size)
+			LSTm_addList(mocsInProgress, levels[i]);
+		else
+			LSTm_delete(levels[i]); // Sizes beyond the last limit.
+		for (int j = 0; j < nbPartials[i]; j++)
+			STA_delete(partials[i][j]);
+		free(partials[i]);
+	}
+	free(nbPartials);
+	free(partials);
+	free(levels);
 }
 
 /**
- * @brief Checks if two atoms in the cage are connected.
- * Uses a Depth-first search.
+ * @brief Cost of a partial path for the best-first searches:
+ * atoms used, lower bound of the atoms still needed to reach the end atom,
+ * and deviation from END_ANGLE of the direction of the path towards the end atom.
  * 
- * @param s Cage without any added paths.
- * @param index1 Starting atom index.
- * @param index2 Ending atom index.
- * @return (int) 1 if they are connected, 0 otherwise.
+ * @param processedMoc Molecular cage being generated.
+ * @param idLast Last atom of the path.
+ * @param idEnd Atom the path is to be connected to.
+ * @param nbAtoms Number of atoms of the path.
+ * @return (float) Cost of the path.
  */
-int checkExistsPath(Shell_t* s, int index1, int index2) {
-	
-	List_t* markedAtoms = NULL;
-	markedAtoms = LST_create();
-	
-	int exists = search(s, markedAtoms, index1, index2);
-	
-	LST_delete(markedAtoms);
-	
-	return exists;
+float pathCost(Shell_t* processedMoc, int idLast, int idEnd, int nbAtoms) {
+
+	float endDist = dist(coords(atom(processedMoc, idLast)), coords(atom(processedMoc, idEnd)));
+
+	return nbAtoms + minAtomsToEnd(endDist) + fabsf(endAngle(processedMoc, idLast, idEnd) - END_ANGLE) / ANGLE_COST;
 }
 
+/**
+ * @brief Generates paths between two grouping of bonding patterns with a best-first search.
+ * The partial paths are ordered by their cost in a bounded priority queue: 
+ * the best one is expanded first (SEARCH_ASTAR), or the paths are expanded level by level 
+ * keeping the BEAM_WIDTH best ones (SEARCH_BEAM). A partial path is stored as the changes 
+ * of the cage since the start of the search, replayed to expand it.
+ * The search stops after maxResults closed paths.
+ * 
+ * @param m Grouping of the main structures (substrate and envelope).
+ * @param mocsInProgress List of cages in construction to be processed.
+ * @param processedMoc Molecular cage being generated.
+ * @param trail Trail of the modifications of the cage.
+ * @param idStart Index of the first linkable atom in the path in construction.
+ * @param idEnd Index of the atom the path in construction is to be connected to.
+ * @param sizeMax Maximale size (in atoms) of a path.
+ * @param maxResults Maximal number of closed paths.
+ * @param startingMocSize Size (in atoms) of the cage before adding the path.
+ * @param forceCycle 1 if the path must contain an aromatic ring.
+ * @param search SEARCH_BEAM or SEARCH_ASTAR.
+ * @param nbPairNodes Number of nodes of the path search of the pair.
+ */
+void searchPaths(Main_t* m, List_m* mocsInProgress, Shell_t* processedMoc, Trail_t* trail, int idStart, int idEnd, int sizeMax, int maxResults, int startingMocSize, int forceCycle, int search, long* nbPairNodes) {
+
+	unsigned base = nbChanges(trail);
+	int nbClosed = 0;
+	Queue_t* frontier = QUE_create(search == SEARCH_BEAM ? BEAM_WIDTH : FRONTIER_SIZE);
+	Queue_t* next = (search == SEARCH_BEAM) ? QUE_create(BEAM_WIDTH) : frontier; // Next level of the beam.
+	State_t* state;
+
+	QUE_push(frontier, STA_create(TRL_create(), idStart, 0, 0, 0));
+
+	while (nbClosed < maxResults && !countNode(m, nbPairNodes) && (state = QUE_pop(frontier))) {
+		TRL_replay(trail, processedMoc, state->path);
+
+		if (!isHinderedExcept(processedMoc, substrat(m), coords(atom(processedMoc, state->idStart)), state->idStart)) {
+			for (int i = 2; i < NB_PATTERNS; i++) {
+				if(i == 3) i++; // TEMP exclude carbonyl pattern
+				List_r* moves = LSTr_init();
+				List_d* newStarts = LSTd_init();
+				
+				insertPattern(processedMoc, trail, moves, state->idStart, newStarts, i, idEnd, substrat(m));
+				
+				while (moves->first) {
+					unsigned mark = nbChanges(trail);
+					int idNewStart = newStarts->first->idAtom;
+					int nbCarbonyls = (i == 3) ? state->nbCarbonyls + 1 : 0;
+					int nbAroRings = (i == 4) ? state->nbAroRings + 1 : state->nbAroRings;
+					
+					TRL_replay(trail, processedMoc, moves->first->move);
+					int nbAtoms = SHL_nbAtom(processedMoc) - startingMocSize;
+					
+					if (sizeMax >= nbAtoms) {
+						float endDist = dist(coords(atom(processedMoc, idNewStart)), coords(atom(processedMoc, idEnd)));
+						
+						if (endDist < DIST_SIMPLE + DIST_ERROR) {
+							if (checkEndAngles(processedMoc, idNewStart, idEnd) && (!forceCycle || nbAroRings > 0)) {
+								TRL_setFlag(trail, processedMoc, idEnd, CARBON_F); // Change end atom (arrival) flag.
+								TRL_addEdge(trail, processedMoc, idNewStart, idEnd); //Add a link between last atom of the path and arrival.
+								LSTm_addElement(mocsInProgress, SHL_copy(processedMoc));// Add to the list to be processed.
+								nbClosed++;
+							}
+						}
+						else if (nbCarbonyls < 5 && nbAroRings < 3
+								&& nbAtoms + minAtomsToEnd(endDist) <= sizeMax
+								&& (!forceCycle || nbAroRings > 0 || nbAtoms + NB_ATOMS_IN_CYCLE <= sizeMax)) {
+							QUE_push(next, STA_create(TRL_copy(trail, base), idNewStart, nbCarbonyls, nbAroRings, pathCost(processedMoc, idNewStart, idEnd, nbAtoms)));
+						}
+					}
+					TRL_undo(trail, processedMoc, mark);
+					LSTr_removeFirst(moves);
+					LSTd_removeFirst(newStarts);
+				}
+				LSTr_delete(moves);
+				LSTd_delete(newStarts);
+			}
+		}
+		TRL_undo(trail, processedMoc, base);
+		STA_delete(state);
+
+		if (next != frontier && frontier->nbStates == 0) { // Next level of the beam.
+			Queue_t* tmp = frontier;
+			frontier = next;
+			next = tmp;
+		}
+	}
+
+	if (next != frontier)
+		QUE_delete(next);
+	QUE_delete(frontier);
+}
+
+/**
+ * @brief Position of the last atom of a half path of the bidirectional search.
+ * 
+ * @param processedMoc Molecular cage being generated.
+ * @param half Half path.
+ * @return (Point_t) Position of the last atom (the atom of the pair for an empty half path).
+ */
+Point_t halfPathTip(Shell_t* processedMoc, State_t* half) {
+
+	for (int i = nbChanges(half->path) - 1; i >= 0; i--)
+		if (half->path->changes[i].type == TRAIL_ATOM)
+			return half->path->changes[i].coords;
+
+	return coords(atom(processedMoc, half->idStart));
+}
+
+/**
+ * @brief Generates the half paths of the bidirectional search from an atom of the pair.
+ * Every partial path is kept (the empty one included) as the changes of the cage since base.
+ * A path is extended until it has half atoms, while it can still reach the other atom within sizeMax atoms
+ * (the bond joining two half paths may be DIST_ERROR longer than a bond of the path).
+ * 
+ * @param m Grouping of the main structures (substrate and envelope).
+ * @param halves Half paths found (reallocated).
+ * @param nbHalves Number of half paths found.
+ * @param processedMoc Molecular cage being generated.
+ * @param trail Trail of the modifications of the cage.
+ * @param base Number of changes of the trail before the half paths.
+ * @param idStart Index of the last atom of the half path.
+ * @param idEnd Index of the other atom of the pair.
+ * @param nbAtoms Number of atoms of the half path.
+ * @param nbAroRings Number of aromatic rings of the half path.
+ * @param half Number of atoms from which a half path is not extended.
+ * @param sizeMax Maximale size (in atoms) of a path.
+ * @param forceCycle 1 if the path must contain an aromatic ring.
+ * @param nbPairNodes Number of nodes of the path search of the pair.
+ */
+void growHalfPaths(Main_t* m, State_t*** halves, int* nbHalves, Shell_t* processedMoc, Trail_t* trail, unsigned base, int idStart, int idEnd, int nbAtoms, int nbAroRings, int half, int sizeMax, int forceCycle, long* nbPairNodes) {
+
+	if (countNode(m, nbPairNodes))
+		return;
+	if (nbAtoms > 0 && isHinderedExcept(processedMoc, substrat(m), coords(atom(processedMoc, idStart)), idStart))
+		return;
+
+	State_t* state = STA_create(TRL_copy(trail, base), idStart, 0, nbAroRings, 0);
+	state->nbAtoms = nbAtoms;
+	*halves = realloc(*halves, (*nbHalves+1)*sizeof(State_t*));
+	(*halves)[(*nbHalves)++] = state;
+
+	if (nbAtoms >= half || nbAroRings >= 3)
+		return;
+
+	for (int i = 2; i < NB_PATTERNS; i++) {
+		if(i == 3) i++; // TEMP exclude carbonyl pattern
+		List_r* moves = LSTr_init();
+		List_d* newStarts = LSTd_init();
+		
+		insertPattern(processedMoc, trail, moves, idStart, newStarts, i, idEnd, substrat(m));
+		
+		while (moves->first && !isSearchOver(m, nbPairNodes)) {
+			unsigned mark = nbChanges(trail);
+			int idNewStart = newStarts->first->idAtom;
+			int nbNewAtoms = nbAtoms - SHL_nbAtom(processedMoc);
+			int nbNewAroRings = (i == 4) ? nbAroRings + 1 : nbAroRings;
+			
+			TRL_replay(trail, processedMoc, moves->first->move);
+			nbNewAtoms += SHL_nbAtom(processedMoc);
+			float endDist = dist(coords(atom(processedMoc, idNewStart)), coords(atom(processedMoc, idEnd)));
+			
+			if (nbNewAtoms > sizeMax) {
+				// Too long.
+			}
+			else if (endDist >= DIST_SIMPLE + DIST_ERROR && nbNewAtoms + minAtomsToEnd(endDist - DIST_ERROR) > sizeMax) {
+				#pragma omp atomic
+				m->budget.nbPrunedDistance++;
+			}
+			else if (forceCycle && nbNewAroRings == 0 && nbNewAtoms + NB_ATOMS_IN_CYCLE > sizeMax) {
+				#pragma omp atomic
+				m->budget.nbPrunedCycle++;
+			}
+			else {
+				growHalfPaths(m, halves, nbHalves, processedMoc, trail, base, idNewStart, idEnd, nbNewAtoms, nbNewAroRings, half, sizeMax, forceCycle, nbPairNodes);
+			}
+			TRL_undo(trail, processedMoc, mark);
+			LSTr_removeFirst(moves);
+			LSTd_removeFirst(newStarts);
+		}
+		LSTr_delete(moves);
+		LSTd_delete(newStarts);
+	}
+}
+
+/**
+ * @brief Generates paths between two grouping of bonding patterns by meeting in the middle.
+ * Half paths of about sizeMax/2 atoms are grown from both atoms of the pair, and the last atoms
+ * of the half paths from idEnd are indexed in a spatial hash. A half path from idStart is joined 
+ * with the half paths whose last atom is at a bond distance (DIST_SIMPLE +- DIST_ERROR) of its own,
+ * if the angles of the bond are close enough to END_ANGLE and the two halves do not collide.
+ * The search stops after maxResults joined paths.
+ * 
+ * @param m Grouping of the main structures (substrate and envelope).
+ * @param mocsInProgress List of cages in construction to be processed.
+ * @param processedMoc Molecular cage being generated.
+ * @param trail Trail of the modifications of the cage.
+ * @param idStart Index of the first linkable atom in the path in construction.
+ * @param idEnd Index of the atom the path in construction is to be connected to.
+ * @param sizeMax Maximale size (in atoms) of a path.
+ * @param maxResults Maximal number of joined paths.
+ * @param forceCycle 1 if the path must contain an aromatic ring.
+ * @param nbPairNodes Number of nodes of the path search of the pair.
+ */
+void bidirectionalPaths(Main_t* m, List_m* mocsInProgress, Shell_t* processedMoc, Trail_t* trail, int idStart, int idEnd, int sizeMax, int maxResults, int forceCycle, long* nbPairNodes) {
+
+	unsigned base = nbChanges(trail), middle;
+	State_t** forward = NULL;
+	State_t** backward = NULL;
+	int nbForward = 0, nbBackward = 0, nbClosed = 0;
+	Grid_t* tips = GRD_create(GRID_CELL_SIZE, GRID_NB_CELLS);
+	List_t* found = LST_create();
+
+	growHalfPaths(m, &forward, &nbForward, processedMoc, trail, base, idStart, idEnd, 0, 0, (sizeMax + 1) / 2, sizeMax, forceCycle, nbPairNodes);
+	TRL_setFlag(trail, processedMoc, idEnd, CARBON_F); // Change end atom (arrival) flag: it starts the other half paths.
+	middle = nbChanges(trail);
+	growHalfPaths(m, &backward, &nbBackward, processedMoc, trail, middle, idEnd, idStart, 0, 0, sizeMax / 2, sizeMax, forceCycle, nbPairNodes);
+
+	for (int j = 0; j < nbBackward; j++)
+		GRD_addAtom(tips, j, halfPathTip(processedMoc, backward[j]));
+
+	for (int i = 0; i < nbForward && nbClosed < maxResults && !isSearchOver(m, nbPairNodes); i++) {
+		State_t* first = forward[i];
+		Point_t firstTip = halfPathTip(processedMoc, first);
+		int nbFound = GRD_getAtoms(tips, firstTip, DIST_SIMPLE + DIST_ERROR, found);
+
+		for (int k = 0; k < nbFound && nbClosed < maxResults; k++) {
+			State_t* second = backward[elts(found, k)];
+			int nbAtoms = first->nbAtoms + second->nbAtoms;
+			int nbAroRings = first->nbAroRings + second->nbAroRings;
+
+			if (nbAtoms == 0 || nbAtoms > sizeMax || nbAroRings > 3 || (forceCycle && nbAroRings == 0)
+					|| dist(firstTip, halfPathTip(processedMoc, second)) < DIST_SIMPLE - DIST_ERROR)
+				continue;
+
+			int idFirstTip = (first->nbAtoms > 0) ? TRL_replay(trail, processedMoc, first->path) : idStart;
+			int hindered = 0;
+
+			// The atoms of the second half must be far enough from the first half (except the two atoms to bond).
+			for (int c = 0; c < nbChanges(second->path) && !hindered; c++) {
+				Change_t* change = second->path->changes + c;
+				if (change->type == TRAIL_ATOM)
+					hindered = isHinderedExcept(processedMoc, substrat(m), change->coords, (change->id1 == second->idStart) ? idFirstTip : -1);
+			}
+
+			if (!hindered) {
+				int idSecondTip = (second->nbAtoms > 0) ? TRL_replay(trail, processedMoc, second->path) : idEnd;
+				if (checkEndAngles(processedMoc, idFirstTip, idSecondTip)) {
+					TRL_addEdge(trail, processedMoc, idFirstTip, idSecondTip); // Join the two halves.
+					LSTm_addElement(mocsInProgress, SHL_copy(processedMoc));// Add to the list to be processed.
+					nbClosed++;
+				}
+			}
+			TRL_undo(trail, processedMoc, middle);
+		}
+	}
+	TRL_undo(trail, processedMoc, base);
+
+	for (int i = 0; i < nbForward; i++)
+		STA_delete(forward[i]);
+	for (int j = 0; j < nbBackward; j++)
+		STA_delete(backward[j]);
+	free(forward);
+	free(backward);
+	LST_delete(found);
+	GRD_delete(tips);
+}
+
+/*************************************************/
+/******* Start and end atoms of the paths ********/
+/*************************************************/
+
 /**
  * @brief Generates a list of every pairs of atoms that can be linked.
  * They must belong to different connected components.
  * 
  * @param s Cage without any added paths.
+ * @param components Connected components of the cage.
  * @return (List_p*) List of pair of atoms to be connected.
  */
-List_p* chooseStartAndEndPairs(Shell_t* s) {
+List_p* chooseStartAndEndPairs(Shell_t* s, Partition_t* components) {
 	
 	List_p* startEndAtoms = LST2_init();
 	
-	for (int i = 0; i < size(s) - 1; i++) {
+	for (int i = 0; i + 1 < size(s); i++) { // size is unsigned (the cage can be empty).
 		if (flag(atom(s, i)) == LINKABLE_F) {
+			int component = PRT_find(components, i);
 			for (int j = i + 1; j < size(s); j++) {
 				if (flag(atom(s, j)) == LINKABLE_F) {
-					if (!checkExistsPath(s, i, j)) {
+					if (PRT_find(components, j) != component) {
 						LST2_addElement(startEndAtoms, i, j);
 					}
 				}
@@ -601,30 +1143,316 @@ List_p* chooseStartAndEndPairs(Shell_t* s) {
 }
 
 /**
- * @brief Initializes the list of moc with the first pathless cage generated.
- * Deletes the list of mocs of the main structure.
+ * @brief Materializes the next pathless cage of the search (a root of the frontier).
+ * The sets of compatible binding patterns are enumerated when a thread runs out of work,
+ * a worker of a sharded search takes one set out of nbShards.
+ * 
+ * @param m Grouping of the main structures (envarom has every binding pattern).
+ * @param roots Enumeration of the sets of compatible patterns (NULL if there is no root to take).
+ * @param shard Index of the worker (0 without sharding).
+ * @param nbShards Number of workers (1 without sharding).
+ * @param pending Number of work items not yet processed (the root is counted).
+ * @return (Work_t*) Root of the frontier, NULL once every set is enumerated.
+ */
+Work_t* nextRoot(Main_t* m, Dependencies_t* roots, int shard, int nbShards, int* pending) {
+
+	unsigned long* set = NULL;
+	Shell_t *moc, *trimmedMoc;
+	Work_t* w;
+
+	if (roots == NULL)
+		return NULL;
+
+	#pragma omp critical (roots)
+	{
+		unsigned long* next;
+
+		while ((next = DEP_next(roots)) != NULL && (roots->nbSets - 1) % nbShards != shard);
+		if (next != NULL) {
+			set = malloc(roots->nbWords*sizeof(unsigned long));
+			memcpy(set, next, roots->nbWords*sizeof(unsigned long));
+			#pragma omp atomic
+			(*pending)++;
+		}
+	}
+	if (set == NULL)
+		return NULL;
+
+	moc = generatePathlessCage(m, roots, set);
+	free(set);
+	// Remove the envelope's atoms.
+	for (int j = 0; j < size(moc); j++) {
+		if (flag(atom(moc,j)) == 0) {
+			SHL_removeAtom(moc, j);
+		}
+	}
+	trimmedMoc = SHL_copyCageAtoms(moc);
+	SHL_delete(moc);
+	// Index the atoms for the clash tests (the copies of the cage keep their grid up to date).
+	if (trimmedMoc->grid == NULL)
+		trimmedMoc->grid = GRD_createFromShell(trimmedMoc);
+
+	w = WRK_create(trimmedMoc, -1, -1, NULL, 0);
+	w->components = PRT_createFromShell(trimmedMoc); // Updated when a path joins two components.
+	w->pathlessSize = SHL_nbAtom(trimmedMoc);
+	return w;
+}
+
+/**************************************/
+/********* Work-stealing search *******/
+/**************************************/
+
+/**
+ * @brief Generates the paths of a pair with the search mode of the options.
  * 
  * @param m Grouping of the main structures (substrate and envelope).
- * @return (List_m*) Initialized list of mocs. 
+ * @param results List of cages in construction to be processed.
+ * @param processedMoc Molecular cage being generated.
+ * @param trail Trail of the modifications of the cage.
+ * @param idStart Starting atom index.
+ * @param idEnd Ending atom index.
+ * @param startingMocSize Size (in atoms) of the cage before adding the path.
+ * @param forceCycle 1 if the path must contain an aromatic ring.
+ * @param options Grouping of inputfile, alpha, sizeMax, maxResults, search.
+ * @param nbPairNodes Number of nodes of the path search of the pair.
  */
-List_m* initMocsInProgress(Main_t* m){
-	List_m* mocsInProgress = LSTm_init();
+void searchPair(Main_t* m, List_m* results, Shell_t* processedMoc, Trail_t* trail, int idStart, int idEnd, int startingMocSize, int forceCycle, Options_t options, long* nbPairNodes) {
+
+	if (options.search == SEARCH_DFS)
+		generatePaths(m, results, processedMoc, trail, idStart, idEnd, 0, 0, options.output, 0, options.sizeMax, startingMocSize, forceCycle, 0, nbPairNodes);
+	else if (options.search == SEARCH_IDDFS)
+		deepeningPaths(m, results, processedMoc, trail, idStart, idEnd, options.output, options.sizeMax, options.maxResults, startingMocSize, forceCycle, nbPairNodes);
+	else if (options.search == SEARCH_BIDIR)
+		bidirectionalPaths(m, results, processedMoc, trail, idStart, idEnd, options.sizeMax, options.maxResults, forceCycle, nbPairNodes);
+	else
+		searchPaths(m, results, processedMoc, trail, idStart, idEnd, options.sizeMax, options.maxResults, startingMocSize, forceCycle, options.search, nbPairNodes);
+}
+
+/**
+ * @brief Generates the cages connecting a pair of atoms of a cage.
+ * 
+ * @param m Grouping of the main structures (substrate and envelope).
+ * @param processedMoc Cage to connect (not modified).
+ * @param idStart Starting atom index.
+ * @param idEnd Ending atom index.
+ * @param options Grouping of inputfile, alpha, sizeMax, maxResults, search.
+ * @return (List_m*) Generated cages (to be processed).
+ */
+List_m* connectPair(Main_t* m, Shell_t* processedMoc, int idStart, int idEnd, Options_t options) {
+
+	List_m* results = LSTm_init();
+	long nbPairNodes = 0; // Budget of the pair (the cages found before it is exhausted are kept).
+	int startingMocSize = SHL_nbAtom(processedMoc);
+	int forceCycle = 0;
+	float startEndDist = dist(coords(atom(processedMoc,idStart)),coords(atom(processedMoc,idEnd)));
 	
-	for (int i = 0; i < mocSize(m); i++) {
-		if (moc(m,i) != NULL) {
-			if (i == 0) { // Only the first moc. TODO? change it
-				LSTm_addElement(mocsInProgress, moc(m, i));
+	if (startEndDist <= DIST_SIMPLE_PATTERN * options.sizeMax + DIST_SIMPLE + DIST_ERROR) {
+		if (startEndDist <= DIST_SIMPLE_PATTERN * (options.sizeMax - NB_ATOMS_IN_CYCLE) + DIST_CYCLE_PATTERN + DIST_SIMPLE + DIST_ERROR
+		&& startEndDist > DIST_CYCLE_PATTERN + (1 * DIST_SIMPLE_PATTERN) + DIST_SIMPLE + DIST_ERROR) {
+			forceCycle = 1;
+		}
+		Shell_t* appendedMoc = SHL_copy(processedMoc); // Create a new moc in the list to process.
+		Trail_t* trail = TRL_create(); // The paths are built in place in appendedMoc.
+		
+		for (int i = 2; i < 3/*4 with carbonyl*/; i++) { // Assignment of all types to the starting atom (atom on the edges).
+
+			flag(atom(appendedMoc, idStart)) = insertType(i);
+			if (i == 3) {
+				if (LST_nbElements(neighborhood(atom(appendedMoc, idStart))) == 1) // Carbonyl possible only if the starting atom has only one neighbor.
+				{
+					List_r* movesWithCarbonyl = addOxygenOfCarbonyl(appendedMoc, trail, idStart,substrat(m));
+
+					while (movesWithCarbonyl->first) { // Process all mocs generated by this addition.
+						unsigned mark = nbChanges(trail);
+						TRL_replay(trail, appendedMoc, movesWithCarbonyl->first->move);
+						searchPair(m, results, appendedMoc, trail, idStart, idEnd, startingMocSize, forceCycle, options, &nbPairNodes);
+						TRL_undo(trail, appendedMoc, mark);
+						LSTr_removeFirst(movesWithCarbonyl);
+					}
+					LSTr_delete(movesWithCarbonyl);
+				}
 			}
-			if (i != 0) {
-				SHL_delete(moc(m,i)); // delete from final solutions list.
+			else {
+				searchPair(m, results, appendedMoc, trail, idStart, idEnd, startingMocSize, forceCycle, options, &nbPairNodes);
 			}
 		}
+		TRL_delete(trail);
+		SHL_delete(appendedMoc);
 	}
-	free(m->mocs);
-	m->mocs = NULL;
-	mocSize(m) = 0;
-	
-	return mocsInProgress;
+	return results;
+}
+
+/**
+ * @brief Gives a connected cage to the result callback of the caller.
+ * The calls are serialized (the callback does not have to be thread safe).
+ * 
+ * @param moc Connected cage.
+ * @param n Index of the result.
+ * @param options Grouping of inputfile, alpha, sizeMax, maxResults, onResult.
+ * @return (int) Nonzero if the caller asks to stop the search.
+ */
+int emitResult(Shell_t* moc, int n, Options_t options) {
+
+	int stop;
+
+	#pragma omp critical (result)
+	stop = options.onResult(moc, n, options.resultData);
+
+	return stop;
+}
+
+/**
+ * @brief Writes a connected cage in the results directory, or gives it to the result callback.
+ * 
+ * @param m Grouping of the main structures (its search is stopped if the caller asks to).
+ * @param moc Connected cage.
+ * @param n Index of the result.
+ * @param pathlessSize Size of the pathless cage of the cage.
+ * @param options Grouping of inputfile, alpha, sizeMax, maxResults, onResult.
+ */
+void writeResult(Main_t* m, Shell_t* moc, int n, int pathlessSize, Options_t options) {
+
+	if (options.onResult == NULL)
+		writeShellOutput(options.results, options.output, moc, pathlessSize, n);
+	else if (emitResult(moc, n, options))
+		stopSearch(m, STOP_CALLER);
+}
+
+/**
+ * @brief Writing stage: the results of the pipe are written, in the order they were found,
+ * while the search threads go on (until the pipe is closed by the last one).
+ * 
+ * @param m Grouping of the main structures (with the pipe).
+ * @param options Grouping of inputfile, alpha, sizeMax, maxResults, onResult.
+ */
+void writeResults(Main_t* m, Options_t options) {
+
+	Result_t r;
+
+	while (PIP_pop(m->pipe, &r)) { // Sleeps while the pipe is empty.
+		writeResult(m, r.moc, r.n, r.pathlessSize, options);
+		SHL_delete(r.moc);
+	}
+}
+
+/**
+ * @brief Processes a work item of the frontier.
+ * A cage is written (or given to the result callback) if it is connected, otherwise its pairs of atoms are pushed.
+ * The results of the pairs of a cage are pushed when its last pair is processed,
+ * in the order of the sequential search (the first result is popped first).
+ * 
+ * @param m Grouping of the main structures (substrate and envelope).
+ * @param w Work item (deleted).
+ * @param deque Deque of the thread.
+ * @param pending Number of work items not yet processed (shared).
+ * @param countResults Number of written cages (shared).
+ * @param options Grouping of inputfile, alpha, sizeMax, maxResults, search.
+ */
+void processWork(Main_t* m, Work_t* w, Deque_t* deque, int* pending, int* countResults, Options_t options) {
+
+	if (w->start == -1 && TBL_checkAndInsert(m->cages, TBL_mix(TBL_fingerprint(w->moc))) && !w->resumed) {
+		// Same cage as a previous one (the same paths added in a different order).
+	}
+	else if (w->start == -1) { // Cage.
+		List_p* startEndAtoms = chooseStartAndEndPairs(w->moc, w->components);
+		
+		if (!startEndAtoms->first) { // If there is only one grouping of patterns left (connected cage).
+			int n;
+			#pragma omp atomic capture
+			n = (*countResults)++;
+			if (n < options.maxResults && m->spool != NULL)
+				spoolResult(m->spool, w->moc, n, SHL_nbAtom(w->moc) - w->pathlessSize);
+			else if (n < options.maxResults && m->pipe != NULL && PIP_push(m->pipe, w->moc, n, w->pathlessSize))
+				w->moc = NULL; // Written by the writing stage.
+			else if (n < options.maxResults) // The pipe is full: the thread writes the result itself.
+				writeResult(m, w->moc, n, w->pathlessSize, options);
+			if (n + 1 >= options.maxResults)
+				stopSearch(m, STOP_RESULTS);
+		}
+		else { // If there are at least 2 groupings of patterns.
+			int nbPairs = 0, i;
+			Element* pair;
+			
+			for (pair = startEndAtoms->first; pair; pair = pair->next)
+				nbPairs++;
+			Group_t* group = GRP_create(w->moc, w->components, nbPairs);
+			group->pathlessSize = w->pathlessSize;
+			w->moc = NULL;
+			w->components = NULL;
+			
+			Work_t** pairs = malloc(nbPairs*sizeof(Work_t*));
+			for (pair = startEndAtoms->first, i = 0; pair; pair = pair->next, i++) {
+				pairs[i] = WRK_create(NULL, pair->start, pair->end, group, i);
+				group->starts[i] = pair->start;
+				group->ends[i] = pair->end;
+			}
+			#pragma omp atomic
+			*pending += nbPairs;
+			for (i = nbPairs - 1; i >= 0; i--) // The first pair is popped first.
+				DEQ_push(deque, pairs[i]);
+			free(pairs);
+		}
+		LST2_delete(startEndAtoms);
+	}
+	else { // Pair of atoms.
+		Group_t* group = w->group;
+		int remaining, stopped;
+		
+		#pragma omp atomic read
+		stopped = m->budget.stop;
+		if (!stopped)
+			group->results[w->index] = connectPair(m, group->moc, w->start, w->end, options);
+		#pragma omp atomic read
+		stopped = m->budget.stop;
+		if (stopped == STOP_CHECKPOINT) { // The results of the pair may be partial.
+			#pragma omp atomic write
+			group->interrupted = 1;
+		}
+		
+		#pragma omp atomic capture
+		remaining = --group->remaining;
+		if (remaining == 0 && group->interrupted) { // The cage is processed again when the search is resumed.
+			Work_t* cage = WRK_create(SHL_copy(group->moc), -1, -1, NULL, 0);
+			cage->components = PRT_copy(group->components);
+			cage->pathlessSize = group->pathlessSize;
+			#pragma omp atomic
+			(*pending)++;
+			DEQ_push(deque, cage);
+			GRP_delete(group);
+		}
+		else if (remaining == 0) { // Last pair of the cage: its results are pushed in the order of the pairs.
+			for (int i = 0; i < group->nbPairs; i++) {
+				List_m* results = group->results[i];
+				Work_t** cages;
+				int nbCages = 0, j;
+				Elem* e;
+				
+				if (results == NULL)
+					continue;
+				for (e = results->first; e; e = e->next)
+					nbCages++;
+				cages = malloc(nbCages*sizeof(Work_t*));
+				for (e = results->first, j = 0; e; e = e->next, j++) {
+					cages[j] = WRK_create(e->moc, -1, -1, NULL, 0);
+					// The path joins the components of its start and end atoms.
+					cages[j]->components = PRT_copy(group->components);
+					PRT_union(cages[j]->components, group->starts[i], group->ends[i]);
+					cages[j]->pathlessSize = group->pathlessSize;
+					e->moc = NULL;
+				}
+				#pragma omp atomic
+				*pending += nbCages;
+				for (j = nbCages - 1; j >= 0; j--) // The last result of the last pair is popped first.
+					DEQ_push(deque, cages[j]);
+				free(cages);
+			}
+			GRP_delete(group);
+		}
+		w->group = NULL;
+	}
+	WRK_delete(w);
+	#pragma omp atomic
+	(*pending)--;
 }
 
 /**************************************/
@@ -632,91 +1460,232 @@ List_m* initMocsInProgress(Main_t* m){
 /**************************************/
 
 /**
- * @brief Generates connected cages and writes them to the results directory.
+ * @brief Wall clock time of the next checkpoint.
+ * 
+ * @param options Grouping of inputfile, alpha, sizeMax, maxResults, checkpoint.
+ * @return (double) omp_get_wtime of the next checkpoint, HUGE_VAL if only on SIGTERM, 0 without checkpoint.
+ */
+double nextCheckpoint(Options_t options) {
+
+	if (options.checkpoint == NULL)
+		return 0;
+	if (options.checkpointInterval == 0)
+		return HUGE_VAL;
+	return omp_get_wtime() + options.checkpointInterval;
+}
+
+/**
+ * @brief Expands the pathless cages into the cages with one path (the frontier shared by the workers).
+ * The pathless cages are expanded into their pairs of atoms, then the pairs are connected, by the threads.
+ * 
+ * @param m Grouping of the main structures (substrate and envelope).
+ * @param deque Deque of the pathless cages (it receives the frontier).
+ * @param pending Number of work items not yet processed.
+ * @param countResults Number of written cages (the pathless cages already connected).
+ * @param options Grouping of inputfile, alpha, sizeMax, maxResults, search.
+ */
+void expandPathless(Main_t* m, Deque_t* deque, int* pending, int* countResults, Options_t options) {
+
+	Work_t** items = NULL;
+	Work_t* w;
+	int nbItems, i, level;
+
+	for (level = 0; level < 2; level++) {
+		for (nbItems = 0; (w = DEQ_pop(deque)) != NULL; nbItems++) {
+			items = realloc(items, (nbItems + 1)*sizeof(Work_t*));
+			items[nbItems] = w;
+		}
+		// The last pair of a cage pushes the cages of all its pairs.
+		#pragma omp parallel for schedule(dynamic)
+		for (i = 0; i < nbItems; i++)
+			processWork(m, items[i], deque, pending, countResults, options);
+	}
+	free(items);
+}
+
+/**
+ * @brief Generates connected cages and writes them to the results directory
+ * (or gives them to the result callback).
+ * The frontier of the cages to process is shared between the threads
+ * with a work-stealing deque per thread.
+ * Every set of compatible binding patterns gives a pathless cage, root of the search:
+ * the sets are enumerated and their cages built when a thread runs out of work,
+ * and the roots share the budgets (of results included).
+ * With several workers (options.workers), the roots (or the cages with one path, if there are
+ * fewer roots than workers) are shared between single threaded processes, and their results are merged
+ * by the parent (which does not search).
+ * The result files are written by their own thread (the writing stage), fed by a bounded pipe.
  * 
  * @param m Grouping of the main structures (substrate and envelope).
  * @param options Grouping of inputfile, alpha, sizeMax, maxResults.
+ * @return (int) Number of results (written before a checkpoint included), -1 if the checkpoint cannot be read.
  */
-void generateWholeCages(Main_t* m, Options_t options) {
+int generateWholeCages(Main_t* m, Options_t options) {
 	
 	printf("\n####### Start of paths generation #######\n");
-	List_m* mocsInProgress = initMocsInProgress(m); // ! Take only the first moc.
-	static int countResults = 0;
+	m->cages = TBL_create(TABLE_SIZE);
+	m->budget.stop = STOP_NONE;
+	m->budget.nbNodes = 0;
+	m->budget.maxNodes = options.maxNodes;
+	m->budget.maxPairNodes = options.maxPairNodes;
+	m->budget.nbPrunedDistance = m->budget.nbPrunedCycle = 0;
+	m->budget.deadline = options.deadline;
+	m->budget.checkpoint = nextCheckpoint(options);
+	int countResults = 0; // Budget of results shared by the threads.
+	int pending = 0; // Number of work items not yet processed.
+	int shard = -1; // Index of the process in a sharded search.
+	pid_t* shards = NULL; // Workers of a sharded search (in the parent).
 
-	// Remove the envelope's atoms.
-	Shell_t* trimmedMoc;
-	for (int j = 0; j < size(mocsInProgress->first->moc); j++) {
-		if (flag(atom(mocsInProgress->first->moc,j)) == 0) {
-			SHL_removeAtom(mocsInProgress->first->moc, j);
+	Dependencies_t* roots = DEP_create(bond(envarom(m))); // Sets of compatible binding patterns.
+	int rootShard = 0, nbRootShards = 1; // Share of the roots of the process.
+	long nbSets = 0;
+
+	if (substrat(m)->grid == NULL)
+		substrat(m)->grid = GRD_createFromMolecule(substrat(m));
+	if (substrat(m)->field == NULL)
+		substrat(m)->field = FLD_create(substrat(m), DIST_GAP_SUBSTRATE, FIELD_VOXEL_SIZE);
+
+	int nbDeques = omp_get_max_threads(), nbThreads = nbDeques;
+	Deque_t** deques = malloc(nbDeques*sizeof(Deque_t*));
+	for (int i = 0; i < nbDeques; i++)
+		deques[i] = DEQ_create();
+	if (options.resume) { // The frontier of the checkpoint, then the roots not yet taken.
+		if ((pending = readCheckpoint(options.checkpoint, deques[0], m->cages, &countResults, &nbSets)) < 0) {
+			for (int i = 0; i < nbDeques; i++) // The checkpoint is kept.
+				DEQ_delete(deques[i]);
+			free(deques);
+			TBL_delete(m->cages);
+			m->cages = NULL;
+			DEP_delete(roots);
+			return -1;
 		}
+		while (roots->nbSets < nbSets && DEP_next(roots));
+		printf("  - Resumed from %s : %d cages to process, %d cages already written\n", options.checkpoint, pending, countResults);
 	}
-	trimmedMoc = SHL_copyCageAtoms(mocsInProgress->first->moc);
-	LSTm_removeFirst(mocsInProgress);
-	LSTm_addElement(mocsInProgress, trimmedMoc);
+	// The workers write their results (without the result callback of the caller, nor checkpoint).
+	// They are forked before any parallel region, and the parent only merges their results.
+	else if (options.workers > 1 && options.onResult == NULL && options.checkpoint == NULL) {
+		Dependencies_t* count = DEP_create(bond(envarom(m)));
+		Work_t* root;
 
-	int pathelessMocSize = SHL_nbAtom(mocsInProgress->first->moc); // Allows to recover the size before the addition of the paths, only if we keep one moc line (TODO modify otherwise).
-	while (mocsInProgress->first) { // As long as there is a moc to process.	
-
-		int startingMocSize = SHL_nbAtom(mocsInProgress->first->moc);
-		List_p* startEndAtoms = chooseStartAndEndPairs(mocsInProgress->first->moc);
-		
-		if (!startEndAtoms->first) { // If there is only one grouping of patterns left (connected cage).
-			if (countResults++ < options.maxResults) {
-				writeShellOutput(options.input, mocsInProgress->first->moc, pathelessMocSize);
-				LSTm_removeFirst(mocsInProgress);
-			}
-			else {
-				LST2_delete(startEndAtoms);
-				free(mocsInProgress);
-				return;
-			}
+		while (count->nbSets < options.workers && DEP_next(count));
+		shards = forkShards(options.workers, &shard);
+		if (shard < 0) { // The workers search the roots.
+			printf("  - Search shared by %d workers\n", options.workers);
+			DEP_delete(roots);
+			roots = NULL;
+		}
+		else if (count->nbSets < options.workers) { // Too few roots: the cages with one path are shared.
+			m->spool = SPL_create(options.results, options.output, shard);
+			nbThreads = 1;
+			while ((root = nextRoot(m, roots, 0, 1, &pending)) != NULL)
+				DEQ_push(deques[0], root);
+			expandPathless(m, deques[0], &pending, &countResults, options); // The same in every worker.
+			keepShard(deques[0], shard, options.workers, &pending);
+		}
+		else {
+			m->spool = SPL_create(options.results, options.output, shard);
+			nbThreads = 1;
+			rootShard = shard;
+			nbRootShards = options.workers;
 		}
-		else { // If there are at least 2 groupings of patterns. 	
-			Shell_t* processedMoc = mocsInProgress->first->moc;
-			mocsInProgress->first->moc = NULL;
-			LSTm_removeFirst(mocsInProgress);
+		DEP_delete(count);
+	}
+	
+	// The result files are written by an extra thread, asleep while there is no result to write,
+	// while the others search (the result callback is called by the search threads: it can stop them at once).
+	if (nbThreads > 1 && m->spool == NULL && options.onResult == NULL)
+		m->pipe = PIP_create(PIPE_SIZE);
+	Idle_t* idle = IDL_create();
+	
+	while (m->budget.stop == STOP_NONE && (pending > 0 || (roots != NULL && roots->depth >= 0))) {
+		int searching; // Number of search threads still running.
+		if (m->pipe != NULL)
+			PIP_open(m->pipe);
+		#pragma omp parallel num_threads(nbThreads + (m->pipe != NULL))
+		{
+			int id = omp_get_thread_num(), nbThreads = omp_get_num_threads();
+		
+			if (m->pipe != NULL && nbThreads > 1) // The last thread is the writing stage.
+				nbThreads--;
+			#pragma omp single
+			searching = nbThreads;
+			if (id == nbThreads)
+				writeResults(m, options);
+
+			while (id < nbThreads) { // As long as there is a work item to process.
+				int remaining, stopped;
+				long epoch = IDL_epoch(idle); // A change after it wakes the thread if it finds no work.
+				if (m->budget.deadline > 0 && omp_get_wtime() > m->budget.deadline)
+					stopSearch(m, STOP_DEADLINE);
+				isCheckpointSignaled(m);
+				#pragma omp atomic read
+				stopped = m->budget.stop;
+				if (stopped) // The items left in the deques are deleted.
+					break;
+				if (omp_get_wtime() > m->budget.checkpoint && m->budget.checkpoint > 0) // The items in progress are finished first.
+					break;
 			
-			while (startEndAtoms->first) { // For all pairs of atoms to connect.
+				Work_t* w = DEQ_pop(deques[id]);
+				for (int i = 1; !w && i < nbThreads; i++) // Steal the oldest item of another thread.
+					w = DEQ_steal(deques[(id + i) % nbThreads]);
+				if (!w) // Build the next pathless cage.
+					w = nextRoot(m, roots, rootShard, nbRootShards, &pending);
 			
-				int idStart = startEndAtoms->first->start;
-				int idEnd = startEndAtoms->first->end;
-				int forceCycle = 0;
-				float startEndDist = dist(coords(atom(processedMoc,idStart)),coords(atom(processedMoc,idEnd)));
-				
-				if (startEndDist <= DIST_SIMPLE_PATTERN * options.sizeMax + DIST_SIMPLE + DIST_ERROR) {
-					if (startEndDist <= DIST_SIMPLE_PATTERN * (options.sizeMax - NB_ATOMS_IN_CYCLE) + DIST_CYCLE_PATTERN + DIST_SIMPLE + DIST_ERROR
-					&& startEndDist > DIST_CYCLE_PATTERN + (1 * DIST_SIMPLE_PATTERN) + DIST_SIMPLE + DIST_ERROR) {
-						forceCycle = 1;
-					}
-					Shell_t* appendedMoc = SHL_copy(processedMoc); // Create a new moc in the list to process.
-					
-		//#pragma omp parallel for
-					for (int i = 2; i < 3/*4 with carbonyl*/; i++) { // Assignment of all types to the starting atom (atom on the edges).
-
-						flag(atom(appendedMoc, idStart)) = insertType(i);
-						if (i == 3) {
-							if (LST_nbElements(neighborhood(atom(appendedMoc, idStart))) == 1) // Carbonyl possible only if the starting atom has only one neighbor.
-							{
-								List_m* mocsWithCarbonyl = addOxygenOfCarbonyl(appendedMoc, idStart,substrat(m));
-
-								while (mocsWithCarbonyl->first) { // Process all mocs generated by this addition.
-									generatePaths(m, mocsInProgress, mocsWithCarbonyl->first->moc, idStart, idEnd, 0, 0, options.input, options.sizeMax, startingMocSize, forceCycle);
-									LSTm_removeFirst(mocsWithCarbonyl);
-								}
-								LSTm_delete(mocsWithCarbonyl);
-							}
-						}
-						else {	
-							generatePaths(m, mocsInProgress, appendedMoc, idStart, idEnd, 0, 0, options.input, options.sizeMax, startingMocSize, forceCycle);
-						}
-					}
-					SHL_delete(appendedMoc);
+				if (w) {
+					processWork(m, w, deques[id], &pending, &countResults, options);
+					IDL_notify(idle);
 				}
-				LST2_removeFirst(startEndAtoms);
+				else {
+					#pragma omp atomic read
+					remaining = pending;
+					if (remaining == 0)
+						break;
+					IDL_wait(idle, epoch); // Until an item is pushed or processed, or a thread stops.
+				}
+			}
+			if (id < nbThreads) {
+				int running;
+				IDL_notify(idle); // The idle threads check if the search is stopped.
+				#pragma omp atomic capture
+				running = --searching;
+				if (running == 0 && m->pipe != NULL) // The writing stage ends once the pipe is empty.
+					PIP_close(m->pipe);
 			}
-			SHL_delete(processedMoc);
 		}
-		LST2_delete(startEndAtoms);
+		if (m->pipe != NULL) // Results left if there was no thread for the writing stage.
+			writeResults(m, options);
+		// The threads are stopped: the frontier is in the deques.
+		if (m->budget.stop == STOP_CHECKPOINT || (m->budget.stop == STOP_NONE && (pending > 0 || (roots != NULL && roots->depth >= 0)))) {
+			writeCheckpoint(options.checkpoint, options.output, deques, nbDeques, m->cages, countResults, roots != NULL ? roots->nbSets : 0);
+			m->budget.checkpoint = nextCheckpoint(options); // The search goes on after an interval.
+		}
 	}
-	free(mocsInProgress);
+	if (options.checkpoint != NULL && m->budget.stop != STOP_CHECKPOINT)
+		remove(options.checkpoint); // The search of this cage is over.
+	
+	for (int i = 0; i < nbDeques; i++)
+		DEQ_delete(deques[i]);
+	free(deques);
+	IDL_delete(idle);
+	PIP_delete(m->pipe);
+	m->pipe = NULL;
+	if (m->spool != NULL)
+		exitShard(m->spool, m, countResults < options.maxResults ? countResults : options.maxResults);
+	if (shards != NULL)
+		countResults = mergeShards(options.results, options.output, shards, options.workers, countResults, options.maxResults);
+	if (roots != NULL)
+		printf("  - Pathless cages : %ld\n", roots->nbSets);
+	printf("  - Explored subtrees : %ld\n  - Pruned subtrees : %ld (distance to the end atom), %ld (aromatic ring)\n",
+		m->budget.nbNodes, m->budget.nbPrunedDistance, m->budget.nbPrunedCycle);
+	if (m->budget.stop != STOP_NONE && m->budget.stop != STOP_RESULTS)
+		printf("  - Search stopped : %s reached\n", STOP_NAME(m->budget.stop));
+	long nbLookups, nbHits, nbEvictions;
+	TBL_stats(m->cages, &nbLookups, &nbHits, &nbEvictions);
+	printf("  - Duplicated cages : %ld / %ld, %ld evictions\n", nbHits, nbLookups, nbEvictions);
+	TBL_delete(m->cages);
+	m->cages = NULL;
+	DEP_delete(roots);
+
+	return countResults < options.maxResults ? countResults : options.maxResults;
 }
@@ -0,0 +1,136 @@
+#include "batch.h"
+#include "cagemol.h"
+#include "constant.h"
+
+/**************************************/
+/* BATCH ******************************/
+/**************************************/
+
+// Line of the manifest: substrate, then alpha, sizeMax and maxResults (separated by tabulations).
+// The missing values are those of the options, the lines starting with # are comments.
+typedef struct {
+
+	char* substrate;
+	double alpha;
+	Job_t job;
+	int done;
+} Entry_t;
+
+/**
+ * Read the lines of a manifest.
+ *
+ * @param manifest File of the manifest.
+ * @param options Default values of the lines.
+ * @param nbEntries Number of lines read (output).
+ * @return (Entry_t*) Lines of the manifest.
+ */
+static Entry_t* readManifest(char* manifest, Options_t options, int* nbEntries) {
+
+	char line[BATCH_LINE_SIZE];
+	char *token, *save;
+	Entry_t* entries = NULL;
+	FILE* f = fopen(manifest, "r");
+
+	if (!f) {
+		fprintf(stderr, "The manifest %s could not be open for reading.\n", manifest);
+		exit(EXIT_FAILURE);
+	}
+
+	*nbEntries = 0;
+	while (fgets(line, BATCH_LINE_SIZE, f)) {
+		Entry_t* e;
+
+		token = strtok_r(line, "\t\r\n", &save);
+		if (token == NULL || token[0] == '#')
+			continue;
+
+		entries = realloc(entries, (*nbEntries+1)*sizeof(Entry_t));
+		e = entries + (*nbEntries)++;
+		e->substrate = malloc(strlen(token) + 1);
+		strcpy(e->substrate, token);
+		e->alpha = (token = strtok_r(NULL, "\t\r\n", &save)) ? atof(token) : options.alphas[0];
+		e->job.sizeMax = (token = strtok_r(NULL, "\t\r\n", &save)) ? atoi(token) : options.sizeMax;
+		e->job.maxResults = (token = strtok_r(NULL, "\t\r\n", &save)) ? atoi(token) : options.maxResults;
+		e->job.nbResults = 0;
+		e->done = 0;
+
+		if (e->alpha <= 0 || e->job.sizeMax <= 0 || e->job.maxResults <= 0) {
+			fprintf(stderr, "Invalid line %d of the manifest %s.\n", *nbEntries, manifest);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	fclose(f);
+	return entries;
+}
+
+/**
+ * Run the jobs of a manifest, grouped by substrate and alpha value.
+ * A substrate is read and its envelopes are computed once, the pathless cages of an alpha value are generated once,
+ * then the jobs of the group (sizeMax and maxResults) are run concurrently.
+ * Each group writes in its own directory of the results.
+ *
+ * @param manifest File of the manifest.
+ * @param options Options of the batch (the default values of the lines).
+ */
+void runBatch(char* manifest, Options_t options) {
+
+	int i, j, k, nbEntries, nbJobs;
+	Entry_t* entries = readManifest(manifest, options, &nbEntries);
+	Job_t* jobs = malloc(nbEntries*sizeof(Job_t));
+
+	for (i = 0; i < nbEntries; i++) {
+		if (entries[i].done)
+			continue;
+
+		// Alpha values of the substrate (its envelopes share the same alpha complex).
+		Options_t group = options;
+		group.input = entries[i].substrate;
+		group.alphas = NULL;
+		group.nbAlphas = 0;
+		for (j = i; j < nbEntries; j++) {
+			if (strcmp(entries[j].substrate, entries[i].substrate))
+				continue;
+			for (k = 0; k < group.nbAlphas && group.alphas[k] != entries[j].alpha; k++);
+			if (k == group.nbAlphas) {
+				group.alphas = realloc(group.alphas, (group.nbAlphas+1)*sizeof(double));
+				group.alphas[group.nbAlphas++] = entries[j].alpha;
+			}
+		}
+
+		printf("\n####### Batch : %s #######\n", entries[i].substrate);
+		int error;
+		CageMol_t* c = CGM_create(group, &error);
+
+		if (c == NULL) { // The jobs of the substrate are skipped.
+			fprintf(stderr, "The substrate %s could not be read : %s.\n", entries[i].substrate, INPUT_ERROR_NAME(error));
+			for (j = i; j < nbEntries; j++)
+				if (!strcmp(entries[j].substrate, entries[i].substrate))
+					entries[j].done = 1;
+		}
+		for (k = 0; k < group.nbAlphas && c != NULL; k++) {
+			nbJobs = 0;
+			for (j = i; j < nbEntries; j++)
+				if (!strcmp(entries[j].substrate, entries[i].substrate) && entries[j].alpha == group.alphas[k]) {
+					int l;
+					for (l = 0; l < nbJobs && (jobs[l].sizeMax != entries[j].job.sizeMax || jobs[l].maxResults != entries[j].job.maxResults); l++);
+					if (l == nbJobs) // The same job is run once.
+						jobs[nbJobs++] = entries[j].job;
+					entries[j].done = 1;
+				}
+
+			CGM_runGrid(c, k, jobs, nbJobs);
+			for (j = 0; j < nbJobs; j++)
+				printf("  - %s, alpha %g, sizemax %d, results %d : %d cages\n", entries[i].substrate, group.alphas[k],
+					jobs[j].sizeMax, jobs[j].maxResults, jobs[j].nbResults);
+		}
+
+		CGM_delete(c);
+		free(group.alphas);
+	}
+
+	for (i = 0; i < nbEntries; i++)
+		free(entries[i].substrate);
+	free(entries);
+	free(jobs);
+}
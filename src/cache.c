@@ -0,0 +1,294 @@
+#include "cache.h"
+#include "constant.h"
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**************************************/
+/* CACHE ******************************/
+/**************************************/
+
+// Cache file : CACHE_MAGIC, then the envelope, the envelope with the aromatic rings and the pathless cages of an alpha value.
+// The lists are written with their free slots, so that the structures read are the same as the ones generated.
+
+// Constants of the generation of the envelope and of the patterns (a cache written with other values is not used).
+static const double cacheConstants[] = {
+	REALLOCSIZE, EDGE_ERROR, DIST_HYDRO, DIST_SIMPLE, DIST_ERROR, MINDIS, DIST_GAP_CAGE, DIST_GAP_SUBSTRATE,
+	DIST_SIMPLE_PATTERN, DIST_CYCLE_PATTERN, NB_ATOMS_IN_CYCLE, SIMPLE_CYCLE, MINDIS_CYCLE, MAXDIS_CYCLE,
+	END_ANGLE, ANGLE_ERROR, NUMBER_POSITION_AX1E3, NB_SUPER_VERTICES, DEL_SUPER_SCALE, DEL_DUPLICATE, DEL_FLAT
+};
+
+/**
+ * Add bytes to a hash (FNV-1a).
+ */
+static unsigned long cacheHash(unsigned long hash, void* data, size_t size) {
+
+	size_t i;
+
+	for (i = 0; i < size; i++)
+		hash = (hash ^ ((unsigned char*)data)[i]) * CACHE_FNV_PRIME;
+
+	return hash;
+}
+
+/**
+ * Key of the pathless cages of a substrate: hash of its atoms (with their radii), of the alpha value,
+ * of the envelope engine and of the constants of the generation.
+ *
+ * @param m Substrate.
+ * @param alpha Alpha value.
+ * @param engine Envelope engine.
+ * @return (unsigned long) Key.
+ */
+unsigned long cacheKey(Molecule_t* m, double alpha, int engine) {
+
+	int i, version = CACHE_VERSION;
+	unsigned long hash = CACHE_FNV_OFFSET;
+
+	hash = cacheHash(hash, &version, sizeof(int));
+	hash = cacheHash(hash, (void*)cacheConstants, sizeof(cacheConstants));
+	hash = cacheHash(hash, &alpha, sizeof(double));
+	hash = cacheHash(hash, &engine, sizeof(int));
+	hash = cacheHash(hash, &size(m), sizeof(unsigned));
+	for (i = 0; i < size(m); i++) {
+		Atom_t* a = atom(m,i);
+
+		hash = cacheHash(hash, symbol(a), sizeof(a->info.symbol) - 1);
+		hash = cacheHash(hash, &coords(a), sizeof(Point_t));
+		hash = cacheHash(hash, &radius(a), sizeof(int));
+		hash = cacheHash(hash, &ligands(a), sizeof(int));
+		hash = cacheHash(hash, &lonePairs(a), sizeof(int));
+	}
+
+	return hash;
+}
+
+/**
+ * Name of the cache file of a key.
+ *
+ * @param dir Directory of the cache.
+ * @param key Key of the pathless cages.
+ * @return (char*) Path of the file (to be freed).
+ */
+char* cacheFile(char* dir, unsigned long key) {
+
+	char* file = malloc(strlen(dir) + 32);
+
+	sprintf(file, "%s/%016lx.bin", dir, key);
+
+	return file;
+}
+
+/**
+ * Read a value of the cache.
+ *
+ * @return (int) 1 if the value is read, 0 if the file is truncated.
+ */
+static int readValue(FILE* f, void* value, size_t size) {
+
+	return fread(value, size, 1, f) == 1;
+}
+
+static void writeList(FILE* f, List_t* l) {
+
+	int n = (l != NULL) ? size(l) : -1; // -1 for a list not allocated.
+
+	fwrite(&n, sizeof(int), 1, f);
+	if (n > 0)
+		fwrite(l->elts, sizeof(int), n, f);
+}
+
+static List_t* readList(FILE* f) {
+
+	int n;
+	List_t* l;
+
+	if (!readValue(f, &n, sizeof(int)))
+		return LST_create(); // Truncated file (seen by the caller).
+	if (n < 0)
+		return NULL;
+
+	l = LST_create();
+	if (n > 0) {
+		l->elts = malloc(n*sizeof(int));
+		size(l) = n;
+		if (fread(l->elts, sizeof(int), n, f) != n)
+			memset(l->elts, -1, n*sizeof(int));
+	}
+
+	return l;
+}
+
+static void writeGraph(FILE* f, Graph_t* g) {
+
+	int i, n = (g != NULL) ? size(g) : -1;
+
+	fwrite(&n, sizeof(int), 1, f);
+	for (i = 0; i < n; i++) {
+		fwrite(&id(vertex(g,i)), sizeof(unsigned), 1, f);
+		fwrite(&nbNeighbors(vertex(g,i)), sizeof(unsigned), 1, f);
+		writeList(f, neighborhood(vertex(g,i)));
+	}
+}
+
+static Graph_t* readGraph(FILE* f) {
+
+	int i, n;
+	Graph_t* g;
+
+	if (!readValue(f, &n, sizeof(int)) || n < 0)
+		return NULL;
+
+	g = GPH_create();
+	g->vertices = calloc(n, sizeof(Vertex_t));
+	size(g) = n;
+	for (i = 0; i < n; i++) {
+		readValue(f, &id(vertex(g,i)), sizeof(unsigned));
+		readValue(f, &nbNeighbors(vertex(g,i)), sizeof(unsigned));
+		neighborhood(vertex(g,i)) = readList(f);
+	}
+
+	return g;
+}
+
+static void writeShell(FILE* f, Shell_t* s) {
+
+	int i, n = (s != NULL) ? size(s) : -1, hasGrid;
+
+	fwrite(&n, sizeof(int), 1, f);
+	if (s == NULL)
+		return;
+
+	for (i = 0; i < n; i++) {
+		AtomShl_t* a = atom(s,i);
+
+		fwrite(&flag(a), sizeof(int), 1, f);
+		fwrite(&coords(a), sizeof(Point_t), 1, f);
+		fwrite(&parentAtom(a), sizeof(unsigned), 1, f);
+		writeList(f, neighborhood(a));
+	}
+	writeList(f, s->cycle);
+	writeGraph(f, s->bond);
+	hasGrid = (s->grid != NULL);
+	fwrite(&hasGrid, sizeof(int), 1, f);
+}
+
+/**
+ * Read a shell written by writeShell.
+ *
+ * @param f Cache file.
+ * @param s Shell read (output, NULL if it was not allocated).
+ * @return (int) 1 if the shell is read, 0 if the file is truncated.
+ */
+static int readShell(FILE* f, Shell_t** s) {
+
+	int i, n, hasGrid;
+
+	*s = NULL;
+	if (!readValue(f, &n, sizeof(int)))
+		return 0;
+	if (n < 0)
+		return 1;
+
+	*s = SHL_create();
+	LST_delete((*s)->cycle);
+	GPH_delete((*s)->bond);
+	(*s)->atoms = malloc(n*sizeof(AtomShl_t));
+	size(*s) = n;
+	for (i = 0; i < n; i++) {
+		AtomShl_t* a = atom(*s,i);
+
+		readValue(f, &flag(a), sizeof(int));
+		readValue(f, &coords(a), sizeof(Point_t));
+		readValue(f, &parentAtom(a), sizeof(unsigned));
+		neighborhood(a) = readList(f);
+	}
+	(*s)->cycle = readList(f);
+	(*s)->bond = readGraph(f);
+	if (!readValue(f, &hasGrid, sizeof(int)))
+		return 0;
+	if (hasGrid)
+		(*s)->grid = GRD_createFromShell(*s);
+
+	return 1;
+}
+
+/**
+ * Read the pathless cages of an alpha value in the cache.
+ *
+ * @param file Cache file.
+ * @param substrate Substrate (shared by the main structure read).
+ * @return (Main_t*) Envelope and pathless cages of the alpha value, NULL if the file does not exist or is invalid.
+ */
+Main_t* readCache(char* file, Molecule_t* substrate) {
+
+	char magic[sizeof(CACHE_MAGIC)] = "";
+	int i, valid;
+	FILE* f = fopen(file, "rb");
+	Main_t* m;
+
+	if (!f)
+		return NULL;
+
+	m = MN_create();
+	substrat(m) = substrate;
+	valid = readValue(f, magic, strlen(CACHE_MAGIC)) && !strcmp(magic, CACHE_MAGIC)
+		&& readShell(f, &envelope(m)) && readShell(f, &envarom(m)) && readValue(f, &mocSize(m), sizeof(unsigned));
+	if (valid) {
+		m->mocs = calloc(mocSize(m), sizeof(Shell_t*));
+		for (i = 0; valid && i < mocSize(m); i++)
+			valid = readShell(f, &moc(m,i));
+	}
+	fclose(f);
+
+	if (!valid) {
+		fprintf(stderr, "The cache file %s is invalid, it is not used.\n", file);
+		substrat(m) = NULL;
+		MN_delete(m);
+		return NULL;
+	}
+
+	return m;
+}
+
+/**
+ * Write the pathless cages of an alpha value in the cache.
+ * The file is replaced only once it is complete (the processes sharing the cache read complete files).
+ *
+ * @param file Cache file.
+ * @param m Envelope and pathless cages of the alpha value.
+ */
+void writeCache(char* file, Main_t* m) {
+
+	int i;
+	char* tmp = malloc(strlen(file) + 32);
+	char* dir = malloc(strlen(file) + 1);
+	FILE* f;
+
+	strcpy(dir, file);
+	*strrchr(dir, '/') = '\0';
+	mkdir(dir, 0755);
+
+	sprintf(tmp, "%s.%d.tmp", file, (int)getpid());
+	f = fopen(tmp, "wb");
+	if (!f) {
+		fprintf(stderr, "The cache file %s could not be open for writing.\n", tmp);
+		free(tmp);
+		free(dir);
+		return;
+	}
+
+	fwrite(CACHE_MAGIC, 1, strlen(CACHE_MAGIC), f);
+	writeShell(f, envelope(m));
+	writeShell(f, envarom(m));
+	fwrite(&mocSize(m), sizeof(unsigned), 1, f);
+	for (i = 0; i < mocSize(m); i++)
+		writeShell(f, moc(m,i));
+
+	if (fclose(f) || rename(tmp, file)) {
+		fprintf(stderr, "The cache file %s could not be written.\n", file);
+		remove(tmp);
+	}
+
+	free(tmp);
+	free(dir);
+}
@@ -0,0 +1,307 @@
+#include "cagemol.h"
+#include "initialization.h"
+#include "expansion.h"
+#include "generation.h"
+#include "assembly.h"
+#include "output.h"
+#include "checkpoint.h"
+#include "cache.h"
+#include <unistd.h>
+#include "constant.h"
+
+/**************************************/
+/* LIBRARY ****************************/
+/**************************************/
+
+struct CageMol {
+
+	Options_t options; // The strings and the alpha values are copies.
+	char* name; // Name of the results (substrate's name).
+	Molecule_t* substrate;
+	Shell_t** envelopes; // Envelope of each alpha value.
+	Main_t** pathless; // Pathless cages of each alpha value (NULL until its first run).
+};
+
+/**
+ * Copy of a string (NULL is kept).
+ */
+static char* CGM_copyString(char* s) {
+
+	char* copy;
+
+	if (s == NULL)
+		return NULL;
+	copy = malloc(strlen(s) + 1);
+	strcpy(copy, s);
+
+	return copy;
+}
+
+/**
+ * Create the context of a substrate: the substrate is read and its envelopes are computed,
+ * unless the pathless cages of every alpha value are in the cache.
+ * The R engine needs an embedded R where alphashape.R is sourced (see main).
+ *
+ * @param options Options of the generation (input is required, the alpha value is the default one if none is given,
+ * the results are written in RESULTS_DIR if results is NULL, and the radii are read in RDC_FILE if radii is NULL).
+ * @param error Set to the error of the input files (INPUT_OK if the context is created), can be NULL.
+ * @return (CageMol_t*) Context of the substrate, NULL if the substrate or the radii cannot be read.
+ */
+CageMol_t* CGM_create(Options_t options, int* error) {
+
+	int i, nbCached = 0, status;
+	Molecule_t* substrate = initMolecule(options.input, options.radii != NULL ? options.radii : RDC_FILE, &status);
+	CageMol_t* c;
+
+	if (error != NULL)
+		*error = status;
+	if (substrate == NULL)
+		return NULL;
+
+	c = malloc(sizeof(CageMol_t));
+
+	c->options = options;
+	c->options.input = CGM_copyString(options.input);
+	c->options.results = CGM_copyString(options.results != NULL ? options.results : RESULTS_DIR);
+	c->options.radii = CGM_copyString(options.radii != NULL ? options.radii : RDC_FILE);
+	c->options.checkpoint = CGM_copyString(options.checkpoint);
+	c->options.cache = CGM_copyString(options.cache);
+	c->options.output = NULL;
+	if (options.nbAlphas == 0) {
+		c->options.alphas = malloc(sizeof(double));
+		c->options.alphas[c->options.nbAlphas++] = DEFLT_ALPHA;
+	}
+	else {
+		c->options.alphas = malloc(options.nbAlphas*sizeof(double));
+		memcpy(c->options.alphas, options.alphas, options.nbAlphas*sizeof(double));
+	}
+
+	c->name = getBasename(c->options.input);
+	c->substrate = substrate;
+	c->pathless = calloc(c->options.nbAlphas, sizeof(Main_t*));
+
+	for (i = 0; i < c->options.nbAlphas && c->options.cache != NULL; i++) {
+		char* file = cacheFile(c->options.cache, cacheKey(c->substrate, c->options.alphas[i], c->options.engine));
+
+		if ((c->pathless[i] = readCache(file, c->substrate)) != NULL) {
+			printf("  - Pathless cages of alpha %g read in the cache %s\n", c->options.alphas[i], file);
+			nbCached++;
+		}
+		free(file);
+	}
+
+	// The envelopes of all alpha values share the same alpha complex.
+	if (nbCached < c->options.nbAlphas)
+		c->envelopes = createShell(c->substrate, c->options.alphas, c->options.nbAlphas, c->options.engine);
+	else
+		c->envelopes = calloc(c->options.nbAlphas, sizeof(Shell_t*));
+
+	return c;
+}
+
+/**
+ * Check if the pathless cages of every alpha value of the options are in the cache
+ * (the envelope engine is then not needed).
+ *
+ * @param options Options of the generation.
+ * @return (int) 1 if they are all in the cache, 0 otherwise (or if the substrate cannot be read).
+ */
+int CGM_isCached(Options_t options) {
+
+	int i, nbCached = 0, error;
+	Molecule_t* m;
+
+	if (options.cache == NULL || options.nbAlphas == 0)
+		return 0;
+
+	m = initMolecule(options.input, options.radii != NULL ? options.radii : RDC_FILE, &error);
+	if (m == NULL)
+		return 0;
+	for (i = 0; i < options.nbAlphas; i++) {
+		char* file = cacheFile(options.cache, cacheKey(m, options.alphas[i], options.engine));
+
+		if (access(file, R_OK) == 0)
+			nbCached++;
+		free(file);
+	}
+	MOL_delete(m);
+
+	return nbCached == options.nbAlphas;
+}
+
+/**
+ * Pathless cages of an alpha value, read in the cache or generated by its first run
+ * (they do not depend on sizeMax and maxResults).
+ *
+ * @param c Context of the substrate.
+ * @param i Index of the alpha value.
+ * @return (Main_t*) Substrate, envelope and pathless cages of the alpha value (owned by the context).
+ */
+static Main_t* CGM_pathless(CageMol_t* c, int i) {
+
+	if (c->pathless[i] == NULL) {
+		Main_t* m = MN_create();
+		substrat(m) = c->substrate;
+		envelope(m) = SHL_copy(c->envelopes[i]);
+		generatePathlessCages(m);
+		if (c->options.cache != NULL) {
+			char* file = cacheFile(c->options.cache, cacheKey(c->substrate, c->options.alphas[i], c->options.engine));
+			writeCache(file, m);
+			free(file);
+		}
+		c->pathless[i] = m;
+	}
+
+	// Indices of the substrate shared by the runs (built before they can run concurrently).
+	if (c->substrate->grid == NULL)
+		c->substrate->grid = GRD_createFromMolecule(c->substrate);
+	if (c->substrate->field == NULL)
+		c->substrate->field = FLD_create(c->substrate, DIST_GAP_SUBSTRATE, FIELD_VOXEL_SIZE);
+
+	return c->pathless[i];
+}
+
+/**
+ * Generate the cages of each alpha value of the context.
+ * The context can be run again (the search restarts, the envelopes and the pathless cages are kept).
+ *
+ * @param c Context of the substrate.
+ * @param onResult Called for each connected cage, NULL to write the result files.
+ * @param data Given to onResult.
+ * @return (int) Number of results, -1 if the checkpoint to resume from cannot be read or is not the one of the context.
+ */
+int CGM_run(CageMol_t* c, Result_f onResult, void* data) {
+
+	int i, nbResults = 0, n;
+	Options_t options = c->options;
+	char* resumed = options.resume ? readCheckpointOutput(options.checkpoint) : NULL; // Results of the checkpoint.
+
+	if (options.resume && resumed == NULL)
+		return -1;
+	options.onResult = onResult;
+	options.resultData = data;
+	c->options.resume = 0; // The checkpoint is removed at the end of the search.
+
+	for (i = 0; i < options.nbAlphas && !checkpointSignal(); i++) {
+
+		// Each alpha value of a sweep has its own result directory.
+		options.output = malloc(256 * sizeof(char));
+		if (options.nbAlphas > 1) {
+			printf("\n####### Alpha : %.1f #######\n", options.alphas[i]);
+			sprintf(options.output, "%s_a%g", c->name, options.alphas[i]);
+		}
+		else
+			strcpy(options.output, c->name);
+
+		// The alpha values before the one of the checkpoint are already processed.
+		if (resumed != NULL && strcmp(resumed, options.output)) {
+			printf("  - Already processed (resumed from %s)\n", options.checkpoint);
+			free(options.output);
+			continue;
+		}
+		options.resume = (resumed != NULL);
+		free(resumed);
+		resumed = NULL;
+
+		Main_t* m = CGM_pathless(c, i);
+
+		/***************************** Whole cages *****/
+
+		if (onResult == NULL)
+			writeMainOutput(options.results, options.output, m);
+
+		n = generateWholeCages(m, options);
+		free(options.output);
+		if (n < 0)
+			return -1;
+		nbResults += n;
+	}
+
+	if (resumed != NULL) {
+		fprintf(stderr, "The checkpoint %s was written for the results %s.\n", options.checkpoint, resumed);
+		free(resumed);
+		return -1;
+	}
+
+	return nbResults;
+}
+
+/**
+ * Run a grid of jobs from the pathless cages of an alpha value, concurrently.
+ * The results of the grid are written in the directory [results]/[name]_a[alpha],
+ * those of a job in its subdirectory [name]_s[sizeMax]_r[maxResults] (the jobs must be distinct).
+ * The threads are shared between the jobs (nested parallelism).
+ *
+ * @param c Context of the substrate.
+ * @param i Index of the alpha value.
+ * @param jobs Jobs (their number of results is set).
+ * @param nbJobs Number of jobs.
+ * @return (int) Number of results of the jobs.
+ */
+int CGM_runGrid(CageMol_t* c, int i, Job_t* jobs, int nbJobs) {
+
+	int j, nbResults = 0, levels = omp_get_max_active_levels();
+	int nbThreads = omp_get_max_threads();
+	char* group = malloc(strlen(c->name) + 64);
+	char* root = malloc(strlen(c->options.results) + strlen(c->name) + 64);
+	Main_t* m = CGM_pathless(c, i);
+
+	sprintf(group, "%s_a%g", c->name, c->options.alphas[i]);
+	sprintf(root, "%s/%s", c->options.results, group);
+	writeMainOutput(c->options.results, group, m);
+
+	omp_set_max_active_levels(2);
+	#pragma omp parallel for schedule(dynamic) num_threads(nbJobs < nbThreads ? nbJobs : nbThreads) reduction(+:nbResults)
+	for (j = 0; j < nbJobs; j++) {
+		Main_t job = *m; // The pathless cages are shared (read only), the job has its own tables and budget.
+		Options_t options = c->options;
+
+		options.sizeMax = jobs[j].sizeMax;
+		options.maxResults = jobs[j].maxResults;
+		options.results = root;
+		options.output = malloc(strlen(c->name) + 64);
+		sprintf(options.output, "%s_s%d_r%d", c->name, jobs[j].sizeMax, jobs[j].maxResults);
+		options.checkpoint = NULL;
+		options.resume = 0;
+		options.onResult = NULL;
+		options.workers = 1; // A fork is not safe in a parallel region.
+
+		omp_set_num_threads(nbThreads / nbJobs > 0 ? nbThreads / nbJobs : 1);
+		jobs[j].nbResults = generateWholeCages(&job, options);
+		nbResults += jobs[j].nbResults;
+		free(options.output);
+	}
+	omp_set_max_active_levels(levels);
+
+	free(root);
+	free(group);
+	return nbResults;
+}
+
+void CGM_delete(CageMol_t* c) {
+
+	int i;
+
+	if (c == NULL)
+		return;
+
+	for (i = 0; i < c->options.nbAlphas; i++) {
+		if (c->envelopes[i] != NULL)
+			SHL_delete(c->envelopes[i]);
+		if (c->pathless[i] != NULL) {
+			substrat(c->pathless[i]) = NULL;
+			MN_delete(c->pathless[i]);
+		}
+	}
+	free(c->pathless);
+	free(c->envelopes);
+	MOL_delete(c->substrate);
+	free(c->options.alphas);
+	free(c->options.input);
+	free(c->options.results);
+	free(c->options.radii);
+	free(c->options.checkpoint);
+	free(c->options.cache);
+	free(c->name);
+	free(c);
+}
@@ -0,0 +1,315 @@
+#include "checkpoint.h"
+#include <signal.h>
+
+/**************************************/
+/* CHECKPOINT *************************/
+/**************************************/
+
+// Checkpoint file : CHECKPOINT_MAGIC, name of the results, number of pathless cages already taken,
+// number of written cages, number of cages of the frontier, then each cage (size of its pathless cage, atoms and cycle),
+// and the keys of the processed cages.
+
+static volatile sig_atomic_t signalReceived = 0;
+
+static void checkpointHandler(int sig) {
+
+	signalReceived = 1;
+}
+
+/**
+ * Write a checkpoint (instead of being killed) when the process receives SIGTERM.
+ */
+void installCheckpointSignal() {
+
+	signal(SIGTERM, checkpointHandler);
+}
+
+/**
+ * @return (int) 1 if SIGTERM was received, 0 otherwise.
+ */
+int checkpointSignal() {
+
+	return signalReceived;
+}
+
+/**
+ * Read a value of the checkpoint (set to 0 if the file is truncated, which feof then tells).
+ */
+static void readValue(FILE* f, void* value, size_t size) {
+
+	if (fread(value, size, 1, f) != 1)
+		memset(value, 0, size);
+}
+
+/**
+ * Write a cage : the size of its pathless cage, its atoms (with the free ones, the indices are kept) and its cycle.
+ */
+static void writeShell(FILE* f, Shell_t* s, int pathlessSize) {
+
+	int i, j, n;
+
+	fwrite(&pathlessSize, sizeof(int), 1, f);
+	fwrite(&size(s), sizeof(unsigned), 1, f);
+	for (i=0; i<size(s); i++) {
+		AtomShl_t* a = atom(s,i);
+
+		n = LST_nbElements(neighborhood(a));
+		fwrite(&flag(a), sizeof(int), 1, f);
+		fwrite(&coords(a), sizeof(Point_t), 1, f);
+		fwrite(&parentAtom(a), sizeof(unsigned), 1, f);
+		fwrite(&n, sizeof(int), 1, f);
+		for (j=0; j<n; j++) // In the same order (the first neighbor of an atom is its predecessor in a path).
+			fwrite(&neighbor(a,j), sizeof(int), 1, f);
+	}
+
+	n = LST_nbElements(s->cycle);
+	fwrite(&n, sizeof(int), 1, f);
+	fwrite(s->cycle->elts, sizeof(int), n, f);
+}
+
+/**
+ * Read a cage written by writeShell (the bonds of the patterns are not used by the search).
+ *
+ * @param pathlessSize Set to the size of the pathless cage of the cage.
+ * @return (Shell_t*) Cage, NULL if the file is truncated or invalid.
+ */
+static Shell_t* readShell(FILE* f, int* pathlessSize) {
+
+	int i, j, n, id;
+	Shell_t* s = SHL_create();
+
+	readValue(f, pathlessSize, sizeof(int));
+	readValue(f, &size(s), sizeof(unsigned));
+	s->atoms = malloc(size(s)*sizeof(AtomShl_t));
+	for (i=0; i<size(s); i++) {
+		AtomShl_t* a = atom(s,i);
+
+		SHL_initAtom(a);
+		readValue(f, &flag(a), sizeof(int));
+		readValue(f, &coords(a), sizeof(Point_t));
+		readValue(f, &parentAtom(a), sizeof(unsigned));
+		readValue(f, &n, sizeof(int));
+		for (j=0; j<n && !feof(f); j++) {
+			readValue(f, &id, sizeof(int));
+			LST_addElement(neighborhood(a), id);
+		}
+	}
+
+	readValue(f, &n, sizeof(int));
+	for (j=0; j<n && !feof(f); j++) {
+		readValue(f, &id, sizeof(int));
+		LST_addElement(s->cycle, id);
+	}
+
+	if (feof(f) || *pathlessSize < 0) {
+		SHL_delete(s);
+		return NULL;
+	}
+	s->grid = GRD_createFromShell(s);
+
+	return s;
+}
+
+/**
+ * Write the keys of a table, from the least recently used one of each stripe.
+ */
+static void writeTable(FILE* f, Table_t* t) {
+
+	int i, id, nbKeys = 0;
+
+	for (i=0; i<t->nbStripes; i++)
+		nbKeys += t->stripes[i].nbSlots;
+	fwrite(&nbKeys, sizeof(int), 1, f);
+
+	for (i=0; i<t->nbStripes; i++)
+		for (id = t->stripes[i].oldest; id != -1; id = t->stripes[i].slots[id].newer)
+			fwrite(&t->stripes[i].slots[id].key, sizeof(unsigned long), 1, f);
+}
+
+/**
+ * Insert in a table the keys written by writeTable.
+ *
+ * @return (int) 1 if the keys are read, 0 if the file is truncated.
+ */
+static int readTable(FILE* f, Table_t* t) {
+
+	int i, nbKeys;
+	unsigned long key;
+
+	readValue(f, &nbKeys, sizeof(int));
+	for (i=0; i<nbKeys && !feof(f); i++) {
+		readValue(f, &key, sizeof(unsigned long));
+		TBL_checkAndInsert(t, key);
+	}
+
+	return !feof(f);
+}
+
+/**
+ * Write the frontier of the search in a checkpoint: the cages of the deques,
+ * and the cages of the pairs of the deques (their pairs are processed again).
+ * The file is replaced only once it is complete.
+ *
+ * @param file Checkpoint file.
+ * @param output Name of the results.
+ * @param deques Deques of the threads.
+ * @param nbDeques Number of deques.
+ * @param cages Processed cages.
+ * @param countResults Number of written cages.
+ * @param nbSets Number of sets of compatible patterns already enumerated (pathless cages taken).
+ */
+void writeCheckpoint(char* file, char* output, Deque_t** deques, int nbDeques, Table_t* cages, int countResults, long nbSets) {
+
+	int i, j, k, nbCages = 0, nbGroups = 0, length = strlen(output);
+	Group_t** groups = NULL; // Groups already written.
+	char* tmp = malloc(strlen(file) + 5);
+	FILE* f;
+
+	sprintf(tmp, "%s.tmp", file);
+	f = fopen(tmp, "wb");
+	if (!f) {
+		fprintf(stderr, "The checkpoint %s could not be open for writing.\n", tmp);
+		exit(EXIT_FAILURE);
+	}
+
+	for (i=0; i<nbDeques; i++)
+		nbCages += deques[i]->bottom - deques[i]->top;
+	fwrite(CHECKPOINT_MAGIC, 1, strlen(CHECKPOINT_MAGIC), f);
+	fwrite(&length, sizeof(int), 1, f);
+	fwrite(output, 1, length, f);
+	fwrite(&nbSets, sizeof(long), 1, f);
+	fwrite(&countResults, sizeof(int), 1, f);
+	fwrite(&nbCages, sizeof(int), 1, f); // Upper bound, rewritten below.
+
+	nbCages = 0;
+	for (i=0; i<nbDeques; i++) {
+		for (j=deques[i]->top; j<deques[i]->bottom; j++) {
+			Work_t* w = deques[i]->items[j];
+
+			if (w->group == NULL) // Cage.
+				writeShell(f, w->moc, w->pathlessSize);
+			else { // Pair: its cage is written once.
+				for (k=0; k<nbGroups && groups[k] != w->group; k++);
+				if (k < nbGroups)
+					continue;
+				groups = realloc(groups, (nbGroups+1)*sizeof(Group_t*));
+				groups[nbGroups++] = w->group;
+				writeShell(f, w->group->moc, w->group->pathlessSize);
+			}
+			nbCages++;
+		}
+	}
+
+	writeTable(f, cages);
+	fseek(f, strlen(CHECKPOINT_MAGIC) + 2*sizeof(int) + sizeof(long) + length, SEEK_SET);
+	fwrite(&nbCages, sizeof(int), 1, f);
+
+	if (fclose(f) || rename(tmp, file)) {
+		fprintf(stderr, "The checkpoint %s could not be written.\n", file);
+		exit(EXIT_FAILURE);
+	}
+	printf("  - Checkpoint : %d cages written in %s\n", nbCages, file);
+
+	free(groups);
+	free(tmp);
+}
+
+/**
+ * Open a checkpoint and read its header.
+ *
+ * @return (FILE*) Checkpoint positioned on its first cage, NULL if it is not a valid checkpoint.
+ */
+static FILE* openCheckpoint(char* file, char** output, long* nbSets, int* countResults, int* nbCages) {
+
+	char magic[sizeof(CHECKPOINT_MAGIC)] = "";
+	int length;
+	FILE* f = fopen(file, "rb");
+
+	if (!f) {
+		fprintf(stderr, "The checkpoint %s could not be open for reading.\n", file);
+		return NULL;
+	}
+
+	readValue(f, magic, strlen(CHECKPOINT_MAGIC));
+	if (strcmp(magic, CHECKPOINT_MAGIC)) {
+		fprintf(stderr, "%s is not a checkpoint.\n", file);
+		fclose(f);
+		return NULL;
+	}
+	readValue(f, &length, sizeof(int));
+	if (length < 0 || feof(f)) {
+		fprintf(stderr, "An error occured while reading the checkpoint %s.\n", file);
+		fclose(f);
+		return NULL;
+	}
+	*output = calloc(length + 1, sizeof(char));
+	readValue(f, *output, length);
+	readValue(f, nbSets, sizeof(long));
+	readValue(f, countResults, sizeof(int));
+	readValue(f, nbCages, sizeof(int));
+	if (*nbSets < 0 || *nbCages < 0 || feof(f)) {
+		fprintf(stderr, "An error occured while reading the checkpoint %s.\n", file);
+		free(*output);
+		fclose(f);
+		return NULL;
+	}
+
+	return f;
+}
+
+/**
+ * Name of the results of a checkpoint (the alpha value being processed).
+ *
+ * @param file Checkpoint file.
+ * @return (char*) Name of the results (to be freed), NULL if it is not a valid checkpoint.
+ */
+char* readCheckpointOutput(char* file) {
+
+	char* output;
+	int countResults, nbCages;
+	long nbSets;
+	FILE* f = openCheckpoint(file, &output, &nbSets, &countResults, &nbCages);
+
+	if (f == NULL)
+		return NULL;
+	fclose(f);
+
+	return output;
+}
+
+/**
+ * Push the cages of a checkpoint in a deque, in the order they were written.
+ *
+ * @param file Checkpoint file.
+ * @param deque Deque where the cages are pushed.
+ * @param cages Processed cages (the ones of the checkpoint are inserted).
+ * @param countResults Number of cages written before the checkpoint.
+ * @param nbSets Number of pathless cages already taken (their enumeration goes on after them).
+ * @return (int) Number of cages pushed, -1 if the checkpoint is not valid (the cages pushed are left in the deque).
+ */
+int readCheckpoint(char* file, Deque_t* deque, Table_t* cages, int* countResults, long* nbSets) {
+
+	char* output;
+	int i, pathlessSize, nbCages;
+	Shell_t* moc;
+	FILE* f = openCheckpoint(file, &output, nbSets, countResults, &nbCages);
+
+	if (f == NULL)
+		return -1;
+
+	for (i=0; i<nbCages && (moc = readShell(f, &pathlessSize)) != NULL; i++) {
+		Work_t* w = WRK_create(moc, -1, -1, NULL, 0);
+		w->pathlessSize = pathlessSize;
+		w->components = PRT_createFromShell(w->moc); // The paths join the components.
+		w->resumed = 1; // The cages of the interrupted pairs are already in the processed cages.
+		DEQ_push(deque, w);
+	}
+	if (i < nbCages || !readTable(f, cages)) {
+		fprintf(stderr, "An error occured while reading the checkpoint %s.\n", file);
+		nbCages = -1;
+	}
+
+	fclose(f);
+	free(output);
+	return nbCages;
+}
@@ -0,0 +1,707 @@
+#include "delaunay.h"
+#include <math.h>
+#include <float.h>
+
+/**************************************/
+/* DELAUNAY ***************************/
+/**************************************/
+
+// Tetrahedron of the triangulation, positively oriented.
+// The neighbor n[i] is the tetrahedron sharing the face opposite to v[i].
+typedef struct {
+	int v[4];
+	int n[4];
+	double center[3];
+	double r2;
+	int alive;
+	int mark;
+} Tetra_t;
+
+typedef struct {
+	double* x; // Coordinates of the points, the last NB_SUPER_VERTICES are the vertices of the super tetrahedron.
+	int nbPoints; // Number of points of the cloud (without the super tetrahedron).
+	int* inserted; // Boolean for each point of the cloud (duplicated points are not inserted).
+
+	Tetra_t* tetras;
+	int nbTetras;
+	int sizeTetras;
+	List_t* freeTetras;
+
+	int stamp;
+	int last;
+} Delaunay_t;
+
+// Alpha complex of the triangulation: every simplex is in the alpha shape for low < alpha,
+// and inside the alpha shape (thus not on its boundary) for high < alpha.
+typedef struct {
+	int nbEdges;
+	int sizeEdges;
+	int* edges; // 2 per edge.
+	double* edgeLow;
+	double* edgeHigh;
+	int* edgeAttached;
+	double* edgeLowTriangles;
+
+	int nbTriangles;
+	int sizeTriangles;
+	int* triangles; // 3 per triangle.
+	double* triangleRho;
+	double* triangleMu;
+	double* triangleMuMax;
+	int* triangleAttached;
+	int* triangleOnHull;
+
+	double* vertexHigh;
+
+	int* hash; // Open addressing table from a pair of points to its edge index.
+	int sizeHash;
+} Complex_t;
+
+#define point(d,i) ((d)->x+3*(i))
+#define isSuper(d,i) ((i) >= (d)->nbPoints)
+#define tetra(d,i) ((d)->tetras+(i))
+
+/**
+ * Signed volume (times 6) of the tetrahedron abcd.
+ * Positive if d is above the plane abc (counterclockwise seen from d).
+ */
+static double orient(double* a, double* b, double* c, double* d) {
+	double u[3] = {b[0]-a[0], b[1]-a[1], b[2]-a[2]};
+	double v[3] = {c[0]-a[0], c[1]-a[1], c[2]-a[2]};
+	double w[3] = {d[0]-a[0], d[1]-a[1], d[2]-a[2]};
+
+	return u[0]*(v[1]*w[2]-v[2]*w[1]) - u[1]*(v[0]*w[2]-v[2]*w[0]) + u[2]*(v[0]*w[1]-v[1]*w[0]);
+}
+
+static double dist2(double* a, double* b) {
+
+	return (a[0]-b[0])*(a[0]-b[0]) + (a[1]-b[1])*(a[1]-b[1]) + (a[2]-b[2])*(a[2]-b[2]);
+}
+
+static void cross(double* u, double* v, double* w) {
+
+	w[0] = u[1]*v[2] - u[2]*v[1];
+	w[1] = u[2]*v[0] - u[0]*v[2];
+	w[2] = u[0]*v[1] - u[1]*v[0];
+}
+
+/**
+ * Computes the circumsphere of a tetrahedron.
+ * A flat tetrahedron gets an infinite radius.
+ */
+static void DEL_circumsphere(Delaunay_t* d, Tetra_t* t) {
+	double *a = point(d, t->v[0]), *b = point(d, t->v[1]), *c = point(d, t->v[2]), *e = point(d, t->v[3]);
+	double u[3] = {b[0]-a[0], b[1]-a[1], b[2]-a[2]};
+	double v[3] = {c[0]-a[0], c[1]-a[1], c[2]-a[2]};
+	double w[3] = {e[0]-a[0], e[1]-a[1], e[2]-a[2]};
+	double vw[3], wu[3], uv[3];
+	double nu = u[0]*u[0]+u[1]*u[1]+u[2]*u[2];
+	double nv = v[0]*v[0]+v[1]*v[1]+v[2]*v[2];
+	double nw = w[0]*w[0]+w[1]*w[1]+w[2]*w[2];
+
+	cross(v, w, vw);
+	cross(w, u, wu);
+	cross(u, v, uv);
+	double det = 2 * (u[0]*vw[0] + u[1]*vw[1] + u[2]*vw[2]);
+
+	if (fabs(det) < DBL_MIN) {
+		t->r2 = DBL_MAX;
+		t->center[0] = a[0];
+		t->center[1] = a[1];
+		t->center[2] = a[2];
+		return;
+	}
+
+	double o[3];
+	for (int i = 0; i < 3; i++) {
+		o[i] = (nu*vw[i] + nv*wu[i] + nw*uv[i]) / det;
+		t->center[i] = a[i] + o[i];
+	}
+	t->r2 = o[0]*o[0] + o[1]*o[1] + o[2]*o[2];
+}
+
+static int DEL_inSphere(Delaunay_t* d, Tetra_t* t, double* p) {
+
+	return dist2(t->center, p) < t->r2;
+}
+
+static int DEL_addTetra(Delaunay_t* d, int a, int b, int c, int e) {
+
+	int indice;
+
+	if (LST_nbElements(d->freeTetras) > 0) {
+		indice = elts(d->freeTetras, LST_nbElements(d->freeTetras) - 1);
+		LST_removeElement(d->freeTetras, indice);
+	}
+	else {
+		if (d->nbTetras == d->sizeTetras) {
+			d->sizeTetras = 2 * d->sizeTetras + REALLOCSIZE;
+			d->tetras = realloc(d->tetras, d->sizeTetras * sizeof(Tetra_t));
+		}
+		indice = d->nbTetras++;
+	}
+
+	Tetra_t* t = tetra(d, indice);
+	t->v[0] = a;
+	t->v[1] = b;
+	t->v[2] = c;
+	t->v[3] = e;
+	for (int i = 0; i < 4; i++)
+		t->n[i] = -1;
+	t->alive = 1;
+	t->mark = 0;
+	DEL_circumsphere(d, t);
+
+	return indice;
+}
+
+/**
+ * Orientation of the point p relative to the face of t opposite to its vertex i,
+ * normalized by the volume of t. Negative if p is on the other side of the face.
+ */
+static double DEL_faceSide(Delaunay_t* d, Tetra_t* t, int i, double* p) {
+	double* q[4];
+
+	for (int j = 0; j < 4; j++)
+		q[j] = point(d, t->v[j]);
+	double volume = orient(q[0], q[1], q[2], q[3]);
+	q[i] = p;
+
+	return orient(q[0], q[1], q[2], q[3]) / volume;
+}
+
+/**
+ * Finds a tetrahedron containing p.
+ * Walks from the last created tetrahedron and falls back on a full scan.
+ */
+static int DEL_locate(Delaunay_t* d, double* p) {
+	int t = d->last, steps = 0, best = -1;
+	double depth, bestDepth = -DBL_MAX;
+
+	while (t != -1 && tetra(d,t)->alive && steps++ < d->nbTetras) {
+		int next = -1;
+		for (int i = 0; i < 4 && next == -1; i++) {
+			if (DEL_faceSide(d, tetra(d,t), i, p) < 0)
+				next = tetra(d,t)->n[i];
+		}
+		if (next == -1)
+			return t;
+		t = next;
+	}
+
+	for (t = 0; t < d->nbTetras; t++) {
+		if (tetra(d,t)->alive) {
+			depth = tetra(d,t)->r2 - dist2(tetra(d,t)->center, p);
+			if (depth > bestDepth) {
+				bestDepth = depth;
+				best = t;
+			}
+		}
+	}
+	return best;
+}
+
+/**
+ * Inserts a point in the triangulation (Bowyer-Watson).
+ * The cavity is grown from the tetrahedron containing the point so that it stays connected,
+ * and enlarged until the point sees all of its boundary faces.
+ *
+ * @param d Triangulation.
+ * @param id Index of the point.
+ * @return (int) 1 if inserted, 0 if the point is a duplicate.
+ */
+static int DEL_insert(Delaunay_t* d, int id) {
+	double* p = point(d, id);
+	int seed = DEL_locate(d, p);
+
+	for (int i = 0; i < 4; i++) {
+		if (dist2(point(d, tetra(d,seed)->v[i]), p) < DEL_DUPLICATE * DEL_DUPLICATE)
+			return 0;
+	}
+
+	List_t* cavity = LST_create();
+	d->stamp++;
+	LST_addElement(cavity, seed);
+	tetra(d,seed)->mark = d->stamp;
+
+	for (int k = 0; forEachElement(cavity, k); k++) {
+		Tetra_t* t = tetra(d, elts(cavity,k));
+		for (int i = 0; i < 4; i++) {
+			int nb = t->n[i];
+			if (nb != -1 && tetra(d,nb)->mark != d->stamp && DEL_inSphere(d, tetra(d,nb), p)) {
+				tetra(d,nb)->mark = d->stamp;
+				LST_addElement(cavity, nb);
+			}
+		}
+	}
+
+	// The point must be strictly in front of every boundary face of the cavity.
+	int changed = 1;
+	while (changed) {
+		changed = 0;
+		for (int k = 0; forEachElement(cavity, k); k++) {
+			Tetra_t* t = tetra(d, elts(cavity,k));
+			for (int i = 0; i < 4; i++) {
+				int nb = t->n[i];
+				if (nb != -1 && tetra(d,nb)->mark != d->stamp && DEL_faceSide(d, t, i, p) < DEL_FLAT) {
+					tetra(d,nb)->mark = d->stamp;
+					LST_addElement(cavity, nb);
+					changed = 1;
+				}
+			}
+		}
+	}
+
+	// Fill the cavity with the tetrahedra made by the point and the boundary faces.
+	List_t* created = LST_create();
+	for (int k = 0; forEachElement(cavity, k); k++) {
+		int idt = elts(cavity,k);
+		for (int i = 0; i < 4; i++) {
+			int nb = tetra(d,idt)->n[i];
+			if (nb == -1 || tetra(d,nb)->mark != d->stamp) {
+				int f[3], l = 0;
+				for (int j = 0; j < 4; j++)
+					if (j != i)
+						f[l++] = tetra(d,idt)->v[j];
+				if (orient(point(d,f[0]), point(d,f[1]), point(d,f[2]), p) < 0) {
+					l = f[0];
+					f[0] = f[1];
+					f[1] = l;
+				}
+				int idNew = DEL_addTetra(d, f[0], f[1], f[2], id);
+				tetra(d,idNew)->mark = -d->stamp;
+				tetra(d,idNew)->n[3] = nb;
+				if (nb != -1) {
+					for (int j = 0; j < 4; j++)
+						if (tetra(d,nb)->n[j] == idt)
+							tetra(d,nb)->n[j] = idNew;
+				}
+				LST_addElement(created, idNew);
+			}
+		}
+	}
+
+	// Link the new tetrahedra together through their faces containing the point.
+	for (int k = 0; forEachElement(created, k); k++) {
+		Tetra_t* t = tetra(d, elts(created,k));
+		for (int i = 0; i < 3; i++) {
+			int a = t->v[(i+1)%3], b = t->v[(i+2)%3];
+			for (int l = 0; forEachElement(created, l) && t->n[i] == -1; l++) {
+				Tetra_t* u = tetra(d, elts(created,l));
+				if (l == k)
+					continue;
+				for (int j = 0; j < 3; j++) {
+					int c = u->v[(j+1)%3], e = u->v[(j+2)%3];
+					if ((a == c && b == e) || (a == e && b == c)) {
+						t->n[i] = elts(created,l);
+						u->n[j] = elts(created,k);
+					}
+				}
+			}
+		}
+	}
+
+	for (int k = 0; forEachElement(cavity, k); k++) {
+		tetra(d, elts(cavity,k))->alive = 0;
+		LST_addElement(d->freeTetras, elts(cavity,k));
+	}
+	d->last = elts(created,0);
+
+	LST_delete(created);
+	LST_delete(cavity);
+	return 1;
+}
+
+/**
+ * Delaunay triangulation of a cloud of points.
+ *
+ * @param x Coordinates of the points (3 per point).
+ * @param nbPoints Number of points.
+ */
+static Delaunay_t* DEL_create(double* x, int nbPoints) {
+	Delaunay_t* d = malloc(sizeof(Delaunay_t));
+	double min[3] = {DBL_MAX, DBL_MAX, DBL_MAX}, max[3] = {-DBL_MAX, -DBL_MAX, -DBL_MAX};
+	double center[3], length = 1;
+	double corners[4][3] = {{1, 1, 1}, {1, -1, -1}, {-1, 1, -1}, {-1, -1, 1}};
+
+	d->nbPoints = nbPoints;
+	d->x = malloc(3 * (nbPoints + NB_SUPER_VERTICES) * sizeof(double));
+	memcpy(d->x, x, 3 * nbPoints * sizeof(double));
+	d->inserted = calloc(nbPoints, sizeof(int));
+	d->tetras = NULL;
+	d->nbTetras = 0;
+	d->sizeTetras = 0;
+	d->freeTetras = LST_create();
+	d->stamp = 0;
+
+	for (int i = 0; i < nbPoints; i++) {
+		for (int j = 0; j < 3; j++) {
+			if (point(d,i)[j] < min[j]) min[j] = point(d,i)[j];
+			if (point(d,i)[j] > max[j]) max[j] = point(d,i)[j];
+		}
+	}
+	for (int j = 0; j < 3; j++) {
+		center[j] = nbPoints ? (min[j] + max[j]) / 2 : 0;
+		if (nbPoints && max[j] - min[j] > length)
+			length = max[j] - min[j];
+	}
+
+	// Super tetrahedron, far enough to not interfere with the simplices of interest.
+	for (int i = 0; i < NB_SUPER_VERTICES; i++)
+		for (int j = 0; j < 3; j++)
+			point(d, nbPoints+i)[j] = center[j] + DEL_SUPER_SCALE * length * corners[i][j];
+
+	int first = nbPoints;
+	if (orient(point(d,first), point(d,first+1), point(d,first+2), point(d,first+3)) > 0)
+		d->last = DEL_addTetra(d, first, first+1, first+2, first+3);
+	else
+		d->last = DEL_addTetra(d, first+1, first, first+2, first+3);
+
+	for (int i = 0; i < nbPoints; i++)
+		d->inserted[i] = DEL_insert(d, i);
+
+	return d;
+}
+
+static void DEL_delete(Delaunay_t* d) {
+
+	free(d->x);
+	free(d->inserted);
+	free(d->tetras);
+	LST_delete(d->freeTetras);
+	free(d);
+}
+
+/**************************************/
+/* ALPHA COMPLEX **********************/
+/**************************************/
+
+static double DEL_rho(Delaunay_t* d, int t) {
+
+	for (int i = 0; i < 4; i++)
+		if (isSuper(d, tetra(d,t)->v[i]))
+			return INFINITY;
+	return sqrt(tetra(d,t)->r2);
+}
+
+static void CPX_rehash(Complex_t* c) {
+
+	c->sizeHash *= 2;
+	c->hash = realloc(c->hash, c->sizeHash * sizeof(int));
+	for (int i = 0; i < c->sizeHash; i++)
+		c->hash[i] = -1;
+
+	for (int e = 0; e < c->nbEdges; e++) {
+		unsigned h = ((unsigned) c->edges[2*e] * 73856093u ^ (unsigned) c->edges[2*e+1] * 19349663u) & (c->sizeHash - 1);
+		while (c->hash[h] != -1)
+			h = (h + 1) & (c->sizeHash - 1);
+		c->hash[h] = e;
+	}
+}
+
+static int CPX_getEdge(Complex_t* c, Delaunay_t* d, int a, int b) {
+
+	if (2 * c->nbEdges >= c->sizeHash)
+		CPX_rehash(c);
+
+	if (a > b) {
+		int tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	unsigned h = ((unsigned) a * 73856093u ^ (unsigned) b * 19349663u) & (c->sizeHash - 1);
+	while (c->hash[h] != -1) {
+		int e = c->hash[h];
+		if (c->edges[2*e] == a && c->edges[2*e+1] == b)
+			return e;
+		h = (h + 1) & (c->sizeHash - 1);
+	}
+
+	if (c->nbEdges == c->sizeEdges) {
+		c->sizeEdges = 2 * c->sizeEdges + REALLOCSIZE;
+		c->edges = realloc(c->edges, 2 * c->sizeEdges * sizeof(int));
+		c->edgeLow = realloc(c->edgeLow, c->sizeEdges * sizeof(double));
+		c->edgeHigh = realloc(c->edgeHigh, c->sizeEdges * sizeof(double));
+		c->edgeAttached = realloc(c->edgeAttached, c->sizeEdges * sizeof(int));
+		c->edgeLowTriangles = realloc(c->edgeLowTriangles, c->sizeEdges * sizeof(double));
+	}
+
+	int e = c->nbEdges++;
+	c->hash[h] = e;
+	c->edges[2*e] = a;
+	c->edges[2*e+1] = b;
+	c->edgeLow[e] = sqrt(dist2(point(d,a), point(d,b))) / 2;
+	c->edgeHigh[e] = 0;
+	c->edgeAttached[e] = 0;
+	c->edgeLowTriangles[e] = INFINITY;
+
+	return e;
+}
+
+static void CPX_addTriangle(Complex_t* c, int a, int b, int e, double rho, double mu, double muMax, int attached, int onHull) {
+
+	if (c->nbTriangles == c->sizeTriangles) {
+		c->sizeTriangles = 2 * c->sizeTriangles + REALLOCSIZE;
+		c->triangles = realloc(c->triangles, 3 * c->sizeTriangles * sizeof(int));
+		c->triangleRho = realloc(c->triangleRho, c->sizeTriangles * sizeof(double));
+		c->triangleMu = realloc(c->triangleMu, c->sizeTriangles * sizeof(double));
+		c->triangleMuMax = realloc(c->triangleMuMax, c->sizeTriangles * sizeof(double));
+		c->triangleAttached = realloc(c->triangleAttached, c->sizeTriangles * sizeof(int));
+		c->triangleOnHull = realloc(c->triangleOnHull, c->sizeTriangles * sizeof(int));
+	}
+
+	int t = c->nbTriangles++;
+	c->triangles[3*t] = a;
+	c->triangles[3*t+1] = b;
+	c->triangles[3*t+2] = e;
+	c->triangleRho[t] = rho;
+	c->triangleMu[t] = mu;
+	c->triangleMuMax[t] = muMax;
+	c->triangleAttached[t] = attached;
+	c->triangleOnHull[t] = onHull;
+}
+
+#define triangleLow(c,t) ((c)->triangleAttached[t] ? (c)->triangleMu[t] : (c)->triangleRho[t])
+
+/**
+ * Computes the intervals of alpha for which each simplex belongs
+ * to the boundary of the alpha shape (Edelsbrunner and Mücke).
+ * A simplex is attached if its smallest circumsphere contains another point,
+ * it then only enters the alpha complex as a face of a bigger simplex.
+ *
+ * @param d Delaunay triangulation.
+ */
+static Complex_t* CPX_create(Delaunay_t* d) {
+	Complex_t* c = calloc(1, sizeof(Complex_t));
+
+	c->sizeHash = 64;
+	while (c->sizeHash < 16 * d->nbPoints)
+		c->sizeHash *= 2;
+	c->hash = malloc(c->sizeHash * sizeof(int));
+	for (int i = 0; i < c->sizeHash; i++)
+		c->hash[i] = -1;
+	c->vertexHigh = calloc(d->nbPoints, sizeof(double));
+
+	for (int t = 0; t < d->nbTetras; t++) {
+		if (!tetra(d,t)->alive)
+			continue;
+		for (int i = 0; i < 4; i++) {
+			int nb = tetra(d,t)->n[i], f[3], l = 0, super = 0;
+			if (nb != -1 && nb < t)
+				continue; // Each face is processed once.
+
+			for (int j = 0; j < 4; j++)
+				if (j != i)
+					f[l++] = tetra(d,t)->v[j];
+			for (int j = 0; j < 3; j++)
+				super += isSuper(d, f[j]);
+
+			if (super) {
+				// Faces linked to the super tetrahedron are never inside the alpha shape.
+				for (int j = 0; j < 3; j++) {
+					int a = f[j], b = f[(j+1)%3];
+					if (!isSuper(d,a) && !isSuper(d,b)) {
+						int idE = CPX_getEdge(c, d, a, b);
+						c->edgeHigh[idE] = INFINITY;
+					}
+					else if (!isSuper(d,a))
+						c->vertexHigh[a] = INFINITY;
+					else if (!isSuper(d,b))
+						c->vertexHigh[b] = INFINITY;
+				}
+				continue;
+			}
+
+			double *a = point(d,f[0]), *b = point(d,f[1]), *e = point(d,f[2]);
+			double ab[3] = {b[0]-a[0], b[1]-a[1], b[2]-a[2]};
+			double ae[3] = {e[0]-a[0], e[1]-a[1], e[2]-a[2]};
+			double n[3], u[3], v[3], center[3];
+			cross(ab, ae, n);
+			double nn = n[0]*n[0] + n[1]*n[1] + n[2]*n[2];
+			cross(n, ab, u);
+			cross(ae, n, v);
+			double nab = ab[0]*ab[0] + ab[1]*ab[1] + ab[2]*ab[2];
+			double nae = ae[0]*ae[0] + ae[1]*ae[1] + ae[2]*ae[2];
+			for (int j = 0; j < 3; j++)
+				center[j] = a[j] + (nae * u[j] + nab * v[j]) / (2 * nn);
+			double rho2 = nn > 0 ? dist2(center, a) : DBL_MAX;
+
+			int opposite[2] = {tetra(d,t)->v[i], -1};
+			double rho1 = DEL_rho(d, t), rho2t = INFINITY;
+			if (nb != -1) {
+				rho2t = DEL_rho(d, nb);
+				for (int j = 0; j < 4; j++)
+					if (tetra(d,nb)->n[j] == t)
+						opposite[1] = tetra(d,nb)->v[j];
+			}
+			int attached = 0;
+			for (int j = 0; j < 2; j++)
+				if (opposite[j] != -1 && !isSuper(d, opposite[j]) && dist2(center, point(d, opposite[j])) < rho2)
+					attached = 1;
+
+			CPX_addTriangle(c, f[0], f[1], f[2], sqrt(rho2), fmin(rho1, rho2t), fmax(rho1, rho2t), attached,
+				isinf(rho1) || isinf(rho2t));
+			int idt = c->nbTriangles - 1;
+
+			for (int j = 0; j < 3; j++) {
+				int idE = CPX_getEdge(c, d, f[j], f[(j+1)%3]);
+				int third = f[(j+2)%3];
+				double mid[3];
+				for (int k = 0; k < 3; k++)
+					mid[k] = (point(d,f[j])[k] + point(d,f[(j+1)%3])[k]) / 2;
+				if (dist2(mid, point(d,third)) < c->edgeLow[idE] * c->edgeLow[idE])
+					c->edgeAttached[idE] = 1;
+				c->edgeLowTriangles[idE] = fmin(c->edgeLowTriangles[idE], triangleLow(c, idt));
+				c->edgeHigh[idE] = fmax(c->edgeHigh[idE], c->triangleMuMax[idt]);
+			}
+		}
+	}
+
+	for (int e = 0; e < c->nbEdges; e++) {
+		if (c->edgeAttached[e])
+			c->edgeLow[e] = c->edgeLowTriangles[e];
+		for (int j = 0; j < 2; j++)
+			c->vertexHigh[c->edges[2*e+j]] = fmax(c->vertexHigh[c->edges[2*e+j]], c->edgeHigh[e]);
+	}
+
+	return c;
+}
+
+static void CPX_delete(Complex_t* c) {
+
+	free(c->edges);
+	free(c->edgeLow);
+	free(c->edgeHigh);
+	free(c->edgeAttached);
+	free(c->edgeLowTriangles);
+	free(c->triangles);
+	free(c->triangleRho);
+	free(c->triangleMu);
+	free(c->triangleMuMax);
+	free(c->triangleAttached);
+	free(c->triangleOnHull);
+	free(c->vertexHigh);
+	free(c->hash);
+	free(c);
+}
+
+static int compareEdges(const void* e1, const void* e2) {
+	const int* a = e1, *b = e2;
+
+	if (a[0] != b[0])
+		return a[0] - b[0];
+	return a[1] - b[1];
+}
+
+/**
+ * Extraction of the boundary of the alpha shape,
+ * in the same layout as the one returned by the R function Rashape3d.
+ *
+ * @param c Alpha complex.
+ * @param d Delaunay triangulation.
+ * @param alpha Alphashape parameter.
+ */
+static Ashape_t* CPX_ashape(Complex_t* c, Delaunay_t* d, double alpha) {
+	Ashape_t* as3d = ASP_create();
+	int i, j, nb;
+
+	// Edges (1-based indices, sorted).
+	int* edges = malloc(2 * c->nbEdges * sizeof(int));
+	for (i = 0, nb = 0; i < c->nbEdges; i++) {
+		if (c->edgeLow[i] < alpha && !(c->edgeHigh[i] < alpha)) {
+			edges[2*nb] = c->edges[2*i];
+			edges[2*nb+1] = c->edges[2*i+1];
+			nb++;
+		}
+	}
+	qsort(edges, nb, 2 * sizeof(int), compareEdges);
+	as3d->nb_edge = 2 * nb;
+	as3d->edge = malloc(as3d->nb_edge * sizeof(double));
+	for (i = 0; i < nb; i++) {
+		as3d->edge[i] = edges[2*i] + 1;
+		as3d->edge[i+nb] = edges[2*i+1] + 1;
+	}
+	free(edges);
+
+	// Triangles (tr1, tr2, tr3, on.ch, attached, rhoT, muT, MuT, fc).
+	for (i = 0, nb = 0; i < c->nbTriangles; i++)
+		if (triangleLow(c,i) < alpha && !(c->triangleMuMax[i] < alpha))
+			nb++;
+	as3d->nb_triang = 9 * nb;
+	as3d->triang = malloc(as3d->nb_triang * sizeof(double));
+	for (i = 0, j = 0; i < c->nbTriangles; i++) {
+		if (triangleLow(c,i) < alpha && !(c->triangleMuMax[i] < alpha)) {
+			as3d->triang[j] = c->triangles[3*i] + 1;
+			as3d->triang[j+nb] = c->triangles[3*i+1] + 1;
+			as3d->triang[j+2*nb] = c->triangles[3*i+2] + 1;
+			as3d->triang[j+3*nb] = c->triangleOnHull[i];
+			as3d->triang[j+4*nb] = c->triangleAttached[i];
+			as3d->triang[j+5*nb] = c->triangleRho[i];
+			as3d->triang[j+6*nb] = c->triangleMu[i];
+			as3d->triang[j+7*nb] = c->triangleMuMax[i];
+			as3d->triang[j+8*nb] = (c->triangleMu[i] < alpha) ? 2 : 3;
+			j++;
+		}
+	}
+
+	// Vertices and their coordinates.
+	for (i = 0, nb = 0; i < d->nbPoints; i++)
+		if (d->inserted[i] && !(c->vertexHigh[i] < alpha))
+			nb++;
+	as3d->nb_vertex = nb;
+	as3d->vertex = malloc(nb * sizeof(double));
+	as3d->nb_x = 3 * nb;
+	as3d->x = malloc(as3d->nb_x * sizeof(double));
+	for (i = 0, j = 0; i < d->nbPoints; i++) {
+		if (d->inserted[i] && !(c->vertexHigh[i] < alpha)) {
+			as3d->vertex[j] = i + 1;
+			as3d->x[j] = point(d,i)[0];
+			as3d->x[j+nb] = point(d,i)[1];
+			as3d->x[j+2*nb] = point(d,i)[2];
+			j++;
+		}
+	}
+
+	as3d->nb_alpha = 1;
+	as3d->alpha = malloc(sizeof(double));
+	as3d->alpha[0] = alpha;
+
+	return as3d;
+}
+
+/**
+ * Native computation of the alpha shapes (replaces the call to R).
+ * The triangulation and its alpha complex (the filtration) are computed once,
+ * then the boundary is extracted for every alpha value.
+ *
+ * @param s 		 Envelope that already has a cloud of points.
+ * @param alphas Aphashape parameters.
+ * @param nbAlphas Number of alpha values.
+ * @return (Ashape_t**) One alpha shape per alpha value.
+ */
+Ashape_t** Nashape3d(Shell_t* s, double* alphas, int nbAlphas) {
+	int i, j, size = SHL_nbAtom(s);
+	double* data = malloc(size*3*sizeof(double));
+	Ashape_t** as3d = malloc(nbAlphas*sizeof(Ashape_t*));
+
+	for (i=0, j=0; i<size(s); i++) {
+		if (flag(atom(s,i)) != NOT_DEF_F) {
+			data[3*j] = atomX(atom(s,i));
+			data[3*j+1] = atomY(atom(s,i));
+			data[3*j+2] = atomZ(atom(s,i));
+			j++;
+		}
+	}
+
+	Delaunay_t* d = DEL_create(data, size);
+	Complex_t* c = CPX_create(d);
+
+	for (i=0; i<nbAlphas; i++)
+		as3d[i] = CPX_ashape(c, d, alphas[i]);
+
+	CPX_delete(c);
+	DEL_delete(d);
+	free(data);
+	return as3d;
+}
@@ -1,6 +1,7 @@
 #include "expansion.h"
 #include "util.h"
 #include "interface.h"
+#include "delaunay.h"
 
 #include "output.h"
 
@@ -214,15 +215,14 @@ void expansion(Molecule_t* m, Shell_t* s) {
 }
 
 /**
- * Construction of the edges of the envelope.
- * Call to R.
+ * Construction of the edges of the envelope from its alpha shape.
+ * The points that are not on the boundary are removed.
  * 
  * @param s				Envelope that already has a cloud of points.
- * @param alpha 	Paramètre de la sphère. (3 est souvent une bonne mesure, 4 sinon)
+ * @param as3d 		Alpha shape of the cloud of points.
  */
-void alphaShape(Shell_t* s, double alpha) {
+void alphaShape(Shell_t* s, Ashape_t* as3d) {
 	int i;
-	Ashape_t* as3d = Cashape3d(s, alpha);
 
 	for (i = 0; i < (as3d->nb_edge/2); i++) {
 		SHL_addEdge(s, as3d->edge[i]-1, as3d->edge[i+as3d->nb_edge/2]-1);
@@ -234,24 +234,45 @@ void alphaShape(Shell_t* s, double alpha) {
 			GPH_removeVertex(bond(s),i);
 		}
 	}
-	ASP_delete(as3d);
 }
 
 /**
- *  Creation of the whole envelope from the molecule.
+ *  Creation of the whole envelopes from the molecule.
+ *  The cloud of points and its alpha complex are computed once,
+ *  then an envelope is extracted for each alpha value.
  *
  * @param m Molecule (input) already instantiated.
- * @param s Envelope (output) created.
+ * @param alphas Alphashape parameters. (3 est souvent une bonne mesure, 4 sinon)
+ * @param nbAlphas Number of alpha values.
+ * @param engine Engine computing the alpha shape (ENGINE_R or ENGINE_NATIVE).
+ * @return (Shell_t**) Envelopes created, one per alpha value.
  */
-Shell_t* createShell(Molecule_t* m, double alpha) {
+Shell_t** createShell(Molecule_t* m, double* alphas, int nbAlphas, int engine) {
+	int i;
+	Ashape_t** as3d;
+	Shell_t** envelopes = malloc(nbAlphas*sizeof(Shell_t*));
 
 	printf("\n####### Start of the envelope and binding patterns generation #######\n");
 	Shell_t* s = SHL_create();
 	expansion(m, s);
 	//SHL_writeMol2("../results/vec.mol2", s);
-	alphaShape(s, alpha);
+
+#ifndef WITHOUT_R
+	if (engine == ENGINE_R)
+		as3d = Cashape3d(s, alphas, nbAlphas);
+	else
+#endif
+		as3d = Nashape3d(s, alphas, nbAlphas);
+
+	for (i = 0; i < nbAlphas; i++) {
+		envelopes[i] = SHL_copy(s);
+		alphaShape(envelopes[i], as3d[i]);
+		ASP_delete(as3d[i]);
+	}
 	//printf("Graphe de dépendance de l'enveloppe.\n");
 	//GPH_write(bond(s));	
 
-	return s;
+	free(as3d);
+	SHL_delete(s);
+	return envelopes;
 }
@@ -4,40 +4,26 @@
 
 
 /**
- * @brief Creation of the beginning of cages according to the dependencies.
+ * @brief Check if an atom of the beginning of the cage is too close to the position of a new atom.
+ * The atoms of the envelope (flag SHELL_F) are ignored.
  * 
- * @param m Grouping of the main structures (substrate and envelope).
+ * @param m Envelope with the beginning of the cage.
+ * @param p Position of the new atom.
+ * @param except Index of an atom ignored (-1 to test all the atoms).
+ * @return (int) 1 if an atom is closer than DIST_GAP_CAGE, 0 otherwise.
  */
-void generateDependancies(Main_t* m) {
-
-	unsigned i, j, copy;
-	Shell_t* mo;
-	Vertex_t* v;
-
-	//Création des différents moc en fonction des dépendances.
-	//mocSize change au fur et à mesure des itérations
-	for (i=0; i</*mocSize(m)*/1	; i++) { //Pour tous les mocs
-		mo = moc(m,i);
-		if (size(moc(m,i)) != 0) {
-			for (j=0; j<size(bond(moc(m,i))); j++) {//Pour tous les sommets
-				v = vertex(bond(moc(m,i)),j);
-
-				if (id(v) != -1 && nbNeighbors(v) > 0) {
-
-					while (nbNeighbors(v) != 0) {
-						copy = MN_copyMoc(m, mo);
-						//printf("copy %d \n", copy);
-						//printf("number copy %d\n", copy);
-						SHL_removeVertex(moc(m, copy), id(v));
-						//printf("neighbor(v,0) = %d\n", neighbor(v,0));
-						SHL_removeVertex(mo, neighbor(v,0));
-					}
-				}
-			}
-		}
-		
-	}
-	//printf("mocSize %d\n", mocSize(m));
+int isTooClose(Shell_t* m, Point_t p, int except) {
+
+	int tooClose = 0;
+	List_t* around = LST_create();
+
+	SHL_getAtoms(m, p, DIST_GAP_CAGE, around);
+	for (int i = 0; forEachElement(around, i) && !tooClose; i++)
+		if (elts(around, i) != except && flag(atom(m, elts(around, i))) != SHELL_F)
+			tooClose = 1;
+
+	LST_delete(around);
+	return tooClose;
 }
 
 /*void checkInsertVertex(Shell_t* m, List_t* l, unsigned idv) {
@@ -102,12 +88,10 @@ void insertAcceptor1(Shell_t* m, unsigned idcenter, Point_t normal, Point_t dir)
 	//Position du troisième :
 	x2 = addPoint(coords(center), rotation(normal, -120, dir));
 
-	for (int i = 0; i < size(m); i++) {
-		if ((flag(atom(m, i)) != NOT_DEF_F) && (flag(atom(m,i)) != SHELL_F) 
-			&& ((dist(coords(atom(m, i)),x1) < DIST_GAP_CAGE)|| (dist(coords(atom(m, i)),x2) < DIST_GAP_CAGE))) {
-			flag(center) = SHELL_F;
-			return;
-		}
+	if (isTooClose(m, x1, -1) || isTooClose(m, x2, -1)) {
+		flag(center) = SHELL_F;
+		LST_delete(l);
+		return;
 	}
 
 	//Ajout du deuxième
@@ -164,12 +148,10 @@ void insertDonor1(Shell_t* m, unsigned idhydro, Point_t normal, Point_t dir) {
 	x2 = addPoint(center, rotation(normal, -120, dir));
 
 
-	for (int i = 0; i < size(m); i++) {
-		if ((flag(atom(m, i)) != NOT_DEF_F) && (flag(atom(m,i)) != SHELL_F) 
-			&& ((dist(coords(atom(m, i)),center) < DIST_GAP_CAGE)||(dist(coords(atom(m, i)),x1) < DIST_GAP_CAGE)||(dist(coords(atom(m, i)),x2) < DIST_GAP_CAGE))) {
-			flag(hydro) = SHELL_F;
-			return;
-		}
+	if (isTooClose(m, center, -1) || isTooClose(m, x1, -1) || isTooClose(m, x2, -1)) {
+		flag(hydro) = SHELL_F;
+		LST_delete(neighborsFirstAtom);
+		return;
 	}
 
 	//Ajout du centre
@@ -236,13 +218,10 @@ void insertDonor2(Shell_t* m, unsigned idhydro, Point_t normal, Point_t dir) {
 	x3 = AX2E2(center, x1, x2, DIST_SIMPLE);
 	//Quatrième sommet du tétraèdre
 	x4 = AX3E1(center, x1, x2, x3, DIST_SIMPLE);
-	for (int l = 0; l< size(m); l++){
-		if((flag(atom(m, l)) != NOT_DEF_F) && (flag(atom(m,l)) != SHELL_F) 
-		&& ((dist(coords(atom(m,l)),center) < DIST_GAP_CAGE) || (dist(coords(atom(m,l)),x2) < DIST_GAP_CAGE)
-		|| (dist(coords(atom(m,l)),x3) < DIST_GAP_CAGE) || (dist(coords(atom(m,l)),x4) < DIST_GAP_CAGE))){
-			flag(hydro) = SHELL_F;
-			return;
-		}
+	if (isTooClose(m, center, -1) || isTooClose(m, x2, -1) || isTooClose(m, x3, -1) || isTooClose(m, x4, -1)) {
+		flag(hydro) = SHELL_F;
+		LST_delete(l);
+		return;
 	}
 	//Ajout centre du motif
 	idc = SHL_addAtom(m, center, -1);
@@ -276,52 +255,43 @@ void insertDonor2(Shell_t* m, unsigned idhydro, Point_t normal, Point_t dir) {
 }
 
 /**
- * @brief Add donor or acceptor hydrogen patterns to the beginning of the cage.
+ * @brief Add donor or acceptor hydrogen patterns to the beginning of a cage.
  * 
- * @param m Grouping of the main structures (substrate and envelope).
+ * @param sub Substrate molecule.
+ * @param s Beginning of the cage (its dependency graph gives the patterns).
  */
-void generateHydrogenPattern(Main_t* m) {
+void generateHydrogenPattern(Molecule_t* sub, Shell_t* s) {
 
 	AtomShl_t *atomShell;
 	Atom_t *parentAtomSub;
 
-	//TODO choose to keep the loop to make the dependencies graph
-	for (int i = 0; i < 1/*mocSize(m)*/; i++) {
-		for (int j = 0; j < size(bond(moc(m, i))); j++) {
-			// Get the atom id from the dependency graph
-			int idAtomShell = id(vertex(bond(moc(m, i)), j));
-
-			if (idAtomShell != -1) {
-				atomShell = atom(moc(m,i), idAtomShell);
-				int tooClose = 0;
-				for (int l = 0; l< size(moc(m,i)); l++) {
-					if((l != idAtomShell) && (flag(atom(moc(m, i), l)) != NOT_DEF_F) && (flag(atom(moc(m, i), l)) != SHELL_F) && (dist(coords(atom(moc(m, i), l)), coords(atomShell)) < DIST_GAP_CAGE)) {
-						tooClose = 1;
-						break;
-					}
+	for (int j = 0; j < size(bond(s)); j++) {
+		// Get the atom id from the dependency graph
+		int idAtomShell = id(vertex(bond(s), j));
+
+		if (idAtomShell != -1) {
+			atomShell = atom(s, idAtomShell);
+			if (!isTooClose(s, coords(atomShell), idAtomShell)) {
+				parentAtomSub = atom(sub, parentAtom(atomShell));
+				if (!strcmp(symbol(parentAtomSub), "H")) {
+					insertAcceptor1(s, idAtomShell, MOL_seekNormal(sub, parentAtom(atomShell), -1), 
+						vector(coords(parentAtomSub), coords(atomShell)));
 				}
-				if(!tooClose) {
-					parentAtomSub = atom(substrat(m), parentAtom(atomShell));
-					if (!strcmp(symbol(parentAtomSub), "H")) {
-						insertAcceptor1(moc(m,i), idAtomShell, MOL_seekNormal(substrat(m), parentAtom(atomShell), -1), 
+				else {
+					int haveTriangularGeometry = (steric(parentAtomSub) == 3);
+					if (haveTriangularGeometry) {
+						insertDonor1(s, idAtomShell, MOL_seekNormal(sub, parentAtom(atomShell), -1), 
 							vector(coords(parentAtomSub), coords(atomShell)));
 					}
 					else {
-						int haveTriangularGeometry = (steric(parentAtomSub) == 3);
-						if (haveTriangularGeometry) {
-							insertDonor1(moc(m,i), idAtomShell, MOL_seekNormal(substrat(m), parentAtom(atomShell), -1), 
-								vector(coords(parentAtomSub), coords(atomShell)));
-						}
-						else {
-							insertDonor2(moc(m,i), idAtomShell, MOL_seekNormal(substrat(m), parentAtom(atomShell), -1), 
-								vector(coords(parentAtomSub), coords(atomShell)));
-						}
+						insertDonor2(s, idAtomShell, MOL_seekNormal(sub, parentAtom(atomShell), -1), 
+							vector(coords(parentAtomSub), coords(atomShell)));
 					}
 				}
 			}
 		}
-		//SHL_testDis(moc(m,i));
 	}
+	//SHL_testDis(s);
 }
 
 /**
@@ -337,6 +307,7 @@ void generateCycle(Shell_t* s) {
 	AtomShl_t* atom;
 	List_t* neighborsNotInCycle;
 	List_t* atomsInCycle = LST_create();
+	List_t* around = LST_create(); // Atoms close to a new atom.
 
 	// Find the atoms of the shell involved in a cycle.
 	for (int i = 0; i < size(s); i++) {
@@ -372,18 +343,18 @@ void generateCycle(Shell_t* s) {
 							coords(atom(s, neighbor(atom, 1))), SIMPLE_CYCLE);
 				idNewNeigbor = SHL_addAtom(s, newNeighborPoint, -1);
 
-				for (int j = 0; j < size(s); j++) {
-					if (flag(atom(s, j)) != NOT_DEF_F && dist(newNeighborPoint, coords(atom(s, j))) < MINDIS_CYCLE) {
-						if (LST_check(neighborsNotInCycle, j)) {
-							LST_removeElement(neighborsNotInCycle, j);
-						}
-						if (cycle(s, j)) {
-							//TODO remove this condition unless needed
-							LST_addElement(atomsInCycle, idNewNeigbor);
-						}
-						if (flag(atom(s, j)) != SHELL_F) {
-							SHL_mergeAtom(s, idNewNeigbor, j);
-						}
+				SHL_getAtoms(s, newNeighborPoint, MINDIS_CYCLE, around);
+				for (int k = 0; forEachElement(around, k); k++) {
+					int j = elts(around, k);
+					if (LST_check(neighborsNotInCycle, j)) {
+						LST_removeElement(neighborsNotInCycle, j);
+					}
+					if (cycle(s, j)) {
+						//TODO remove this condition unless needed
+						LST_addElement(atomsInCycle, idNewNeigbor);
+					}
+					if (flag(atom(s, j)) != SHELL_F) {
+						SHL_mergeAtom(s, idNewNeigbor, j);
 					}
 				}
 				if (flag(atom(s, idNewNeigbor)) <= LINKABLE_F) {
@@ -396,19 +367,51 @@ void generateCycle(Shell_t* s) {
 		LST_delete(neighborsNotInCycle);
 	}
 	LST_delete(atomsInCycle);
+	LST_delete(around);
 }
 
+/**
+ * @brief Creation of the beginning of a cage from a set of compatible binding patterns:
+ * the patterns in conflict with the set are removed from the dependency graph,
+ * then the hydrogen patterns of the set are inserted.
+ * 
+ * @param m Grouping of the main structures (envarom has every binding pattern).
+ * @param d Dependencies of the binding patterns of envarom.
+ * @param set Set of compatible patterns (see DEP_next).
+ * @return (Shell_t*) Beginning of the cage.
+ */
+Shell_t* generatePathlessCage(Main_t* m, Dependencies_t* d, unsigned long* set) {
+
+	Shell_t* s = SHL_copy(envarom(m));
+
+	for (int v = 0; v < d->nbVertices; v++)
+		if (!DEP_check(d, set, v))
+			SHL_removeVertex(s, d->ids[v]);
+	generateHydrogenPattern(substrat(m), s);
+
+	return s;
+}
+
+/**
+ * @brief Creation of the envelope with its aromatic rings, and of the first beginning of cage (moc 0).
+ * The other beginnings of cages (the other sets of compatible patterns) are built by the path search
+ * when it needs them.
+ * 
+ * @param m Grouping of the main structures (substrate and envelope).
+ */
 void generatePathlessCages(Main_t* m) {
 
 	envarom(m) = SHL_copy(envelope(m));
-	//generateDependancies(m);
+	// Index of the atoms for the proximity tests (the copies of envarom keep it up to date).
+	envarom(m)->grid = GRD_createFromShell(envarom(m));
 	printf("### Aromatic rings generation ###\n");
 	generateCycle(envarom(m));
 	//SHL_write(envarom(m));
 
 	printf("### Hydrogen patterns generation ###\n");
-	MN_copyMoc(m, envarom(m));
-	generateDependancies(m);
-	generateHydrogenPattern(m);
+	Dependencies_t* d = DEP_create(bond(envarom(m)));
+	unsigned first = MN_getIndiceFree(m); // Before the assignment: the array of mocs may be reallocated.
+	moc(m, first) = generatePathlessCage(m, d, DEP_next(d));
+	DEP_delete(d);
 
 }
@@ -91,13 +91,20 @@ void computeLonePairs(Molecule_t* m) {
  * Initialize the whole molecule.
  *
  * @param name File name of the molecule.
- * @return (Molecule_t) adress of the molecule. 
+ * @param radii File of the covalent radii.
+ * @param error Set to the error of the input (INPUT_OK if the molecule is read).
+ * @return (Molecule_t) adress of the molecule, NULL if the input is invalid. 
  */
-Molecule_t* initMolecule(char* name) {
+Molecule_t* initMolecule(char* name, char* radii, int* error) {
 	
-	Molecule_t* m = readInput_xyz(name);
+	Molecule_t* m = readInput_xyz(name, error);
 
-	readCovalence(m);
+	if (m == NULL)
+		return NULL;
+	if ((*error = readCovalence(m, radii)) != INPUT_OK) {
+		MOL_delete(m);
+		return NULL;
+	}
 	computeLonePairs(m);
 
 	MOL_createBond(m);
@@ -5,88 +5,163 @@
 /* INITIALISATION MOLÉCULE ************/
 /**************************************/
 
+// Table of the covalent radii, read once by process (the jobs of a server share it).
+typedef struct {
+
+	char symbol[INPUT_SYMBOL_SIZE];
+	int radius;
+} Radius_t;
+
+static char* radiiFile = NULL; // File of the table (NULL until it is read).
+static Radius_t* radii = NULL;
+static int nbRadii = 0;
+
 /**
 * Retrieves the file containing the molecule data.
 * Must have an .xyz extension.
 *
 * @param inputname Name of the file containing the molecule data.
-* @param m Address of the molecule.
+* @param error Set to the error of the input (INPUT_OK if the molecule is read).
+* @return (Molecule_t*) Molecule read, NULL if the input is invalid.
 */
-Molecule_t* readInput_xyz(char* inputname) {
+Molecule_t* readInput_xyz(char* inputname, int* error) {
 	FILE* filestream = NULL;
-	int size, ret;
+	char symbol[INPUT_LINE_SIZE];
+	int size;
 	Molecule_t* m;
-	
+
 	filestream = fopen(inputname, "r");
 
   if(!filestream) {
     fprintf(stderr, "The file %s could not be open for reading.\n", inputname);
-    exit(EXIT_FAILURE);
+    *error = INPUT_UNREADABLE;
+    return NULL;
   }
-	
-	ret = fscanf(filestream, "%d", &size);
+
+	if (fscanf(filestream, "%d", &size) != 1 || size <= 0) {
+		fprintf(stderr, "An error occured while reading %s.\n", inputname);
+		fclose(filestream);
+		*error = INPUT_INVALID_SIZE;
+		return NULL;
+	}
 	m = MOL_create(size);
-	
-	for (int i = 0; i < size(m); i++) {
-		ret = fscanf(filestream, "%s %f %f %f", symbol(atom(m,i)), 
-			&atomX(atom(m,i)), &atomY(atom(m,i)),	&atomZ(atom(m,i)));
+	*error = INPUT_OK;
+
+	for (int i = 0; i < size(m) && *error == INPUT_OK; i++) {
+		if (fscanf(filestream, "%255s %f %f %f", symbol,
+			&atomX(atom(m,i)), &atomY(atom(m,i)),	&atomZ(atom(m,i))) != 4)
+			*error = INPUT_INVALID_ATOM;
+		else if (strlen(symbol) >= INPUT_SYMBOL_SIZE)
+			*error = INPUT_UNKNOWN_ELEMENT;
+		else
+			strcpy(symbol(atom(m,i)), symbol);
 	}
-	
+
 	fclose(filestream);
-	
-	if (ret < 0) {
-		fprintf(stderr, "An error occured while reading %s.\n", inputname);
-		exit(EXIT_FAILURE);
+
+	if (*error != INPUT_OK) {
+		fprintf(stderr, "An error occured while reading %s : %s.\n", inputname, INPUT_ERROR_NAME(*error));
+		MOL_delete(m);
+		return NULL;
 	}
 
 	return m;
 }
 
 /**
-* Retrieves the covalent radius of atoms.
-* They are stored in the rdc.dat file.
+* Reads the table of the covalent radii, unless it is already read.
 *
-* @param m Address of the molecule.
+* @param file File of the covalent radii.
+* @return (int) Error of the table (INPUT_OK if it is read).
 */
-void readCovalence(Molecule_t* m) {
+static int loadRadii(char* file) {
   FILE* filestream = NULL;
-  int i, j, number, ret;
-  Atom_t* atoms;
-  
-  filestream = fopen("resources/rdc.dat", "r");
+  char symbol[INPUT_LINE_SIZE];
+  int i, number;
+
+  if (radiiFile != NULL && !strcmp(radiiFile, file))
+    return INPUT_OK;
+
+  filestream = fopen(file, "r");
 
   if(!filestream) {
-    fprintf(stderr, "The file resources/rdc.dat could not be open for reading.\n");
-    exit(EXIT_FAILURE);
+    fprintf(stderr, "The file %s could not be open for reading.\n", file);
+    return INPUT_UNREADABLE;
+  }
+
+  if (fscanf(filestream, "%d", &number) != 1 || number <= 0) {
+    fprintf(stderr, "An error occured while reading %s.\n", file);
+    fclose(filestream);
+    return INPUT_INVALID_RADII;
   }
-  
-  ret = fscanf(filestream, "%d", &number);
-  atoms = malloc(number*sizeof(Atom_t));
+  free(radii);
+  free(radiiFile);
+  radiiFile = NULL;
+  radii = malloc(number*sizeof(Radius_t));
+  nbRadii = number;
 
   // Retrieves the covalent radius.
   for (i = 0; i < number; i++) {
-    ret = fscanf(filestream, "%s %u", symbol(atoms+i), &radius(atoms+i));
-  }
-  
-  for (i = 0; i < size(m); i++) {
-    // Find the corresponding symbol for each atom.
-    for (j = 0; strcmp(symbol(atom(m,i)), symbol(atoms + j)) && j < number; j++);
-
-    if (number <= j) {
-      fprintf(stderr, "The %s atom is not referenced.\n", symbol(atom(m,i)));
-      exit(EXIT_FAILURE);
-    }
-    else {
-      radius(atom(m,i)) = radius(atoms + j);
+    if (fscanf(filestream, "%255s %d", symbol, &radii[i].radius) != 2 || strlen(symbol) >= INPUT_SYMBOL_SIZE) {
+      fprintf(stderr, "An error occured while reading %s.\n", file);
+      fclose(filestream);
+      return INPUT_INVALID_RADII;
     }
+    strcpy(radii[i].symbol, symbol);
   }
 
   fclose(filestream);
 
-  free(atoms);
+  radiiFile = malloc(strlen(file) + 1);
+  strcpy(radiiFile, file);
 
-  if (ret < 0) {
-    fprintf(stderr, "An error occured while reading resources/rdc.dat.\n");
-    exit(EXIT_FAILURE);
+  return INPUT_OK;
+}
+
+/**
+* Reads the table of the covalent radii once, before the molecules need it
+* (for instance before the workers of a server are forked).
+*
+* @param file File of the covalent radii (RDC_FILE by default).
+* @return (int) Error of the table (INPUT_OK if it is read).
+*/
+int readRadii(char* file) {
+  int error;
+
+  #pragma omp critical (radii)
+  error = loadRadii(file);
+
+  return error;
+}
+
+/**
+* Retrieves the covalent radius of atoms.
+* They are stored in the rdc.dat file.
+*
+* @param m Address of the molecule.
+* @param file File of the covalent radii (RDC_FILE by default).
+* @return (int) Error of the input (INPUT_OK if every atom is referenced).
+*/
+int readCovalence(Molecule_t* m, char* file) {
+  int i, j, error;
+
+  #pragma omp critical (radii)
+  {
+    error = loadRadii(file);
+
+    for (i = 0; i < size(m) && error == INPUT_OK; i++) {
+      // Find the corresponding symbol for each atom.
+      for (j = 0; j < nbRadii && strcmp(symbol(atom(m,i)), radii[j].symbol); j++);
+
+      if (nbRadii <= j) {
+        fprintf(stderr, "The %s atom is not referenced.\n", symbol(atom(m,i)));
+        error = INPUT_UNKNOWN_ELEMENT;
+      }
+      else {
+        radius(atom(m,i)) = radii[j].radius;
+      }
+    }
   }
+
+  return error;
 }
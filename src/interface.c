@@ -1,18 +1,23 @@
 #include "interface.h"
 #include <string.h>
 
+#ifndef WITHOUT_R
+
 #include <R.h>
 #include <Rinternals.h>
 #include <Rembedded.h>
 
 /**
  * Call to R.
+ * The alpha shapes of every alpha value are computed with a single triangulation.
  *
  * @param s 		 Envelope that already has a cloud of points.
- * @param alpha  Aphashape parameter.
+ * @param alphas Aphashape parameters.
+ * @param nbAlphas Number of alpha values.
+ * @return (Ashape_t**) One alpha shape per alpha value.
  */
-Ashape_t* Cashape3d(Shell_t* s, double alpha) {
-	Ashape_t* as3d = ASP_create();
+Ashape_t** Cashape3d(Shell_t* s, double* alphas, int nbAlphas) {
+	Ashape_t** as3d = malloc(nbAlphas*sizeof(Ashape_t*));
 	int i, j, size = SHL_nbAtom(s);
 	double* data = malloc(size*3*sizeof(double));
 
@@ -31,8 +36,8 @@ Ashape_t* Cashape3d(Shell_t* s, double alpha) {
 	memcpy (REAL(arg), data, 3*size*sizeof(double));
 
 	SEXP alp2;
-	PROTECT (alp2 = allocVector (REALSXP, 1) );
-	memcpy (REAL(alp2), &alpha, sizeof (double));
+	PROTECT (alp2 = allocVector (REALSXP, nbAlphas) );
+	memcpy (REAL(alp2), alphas, nbAlphas*sizeof (double));
 
 	//Configuration de la fonction R pour l'appel.
 	SEXP Rashape3d_call;
@@ -41,26 +46,33 @@ Ashape_t* Cashape3d(Shell_t* s, double alpha) {
 	int errorOccurred;
 	SEXP ret = R_tryEval(Rashape3d_call, R_GlobalEnv, &errorOccurred);
 
-	if (!errorOccurred && length(ret)==5) {
-		as3d->nb_triang = length(VECTOR_ELT(ret, 0));
-		as3d->triang = malloc(as3d->nb_triang*sizeof(double));
-		memcpy(as3d->triang, REAL(VECTOR_ELT(ret,0)), as3d->nb_triang*sizeof(double));
+	for (i=0; i<nbAlphas; i++) {
+		as3d[i] = ASP_create();
+
+		if (errorOccurred || length(ret) != nbAlphas || length(VECTOR_ELT(ret, i)) != 5)
+			continue;
+
+		SEXP asp = VECTOR_ELT(ret, i);
 
-		as3d->nb_edge = length(VECTOR_ELT(ret, 1));
-		as3d->edge = malloc(as3d->nb_edge*sizeof(double));
-		memcpy(as3d->edge, REAL(VECTOR_ELT(ret,1)), as3d->nb_edge*sizeof(double));
+		as3d[i]->nb_triang = length(VECTOR_ELT(asp, 0));
+		as3d[i]->triang = malloc(as3d[i]->nb_triang*sizeof(double));
+		memcpy(as3d[i]->triang, REAL(VECTOR_ELT(asp,0)), as3d[i]->nb_triang*sizeof(double));
 
-		as3d->nb_vertex = length(VECTOR_ELT(ret, 2));
-		as3d->vertex = malloc(as3d->nb_vertex*sizeof(double));
-		memcpy(as3d->vertex, REAL(VECTOR_ELT(ret,2)), as3d->nb_vertex*sizeof(double));
+		as3d[i]->nb_edge = length(VECTOR_ELT(asp, 1));
+		as3d[i]->edge = malloc(as3d[i]->nb_edge*sizeof(double));
+		memcpy(as3d[i]->edge, REAL(VECTOR_ELT(asp,1)), as3d[i]->nb_edge*sizeof(double));
+
+		as3d[i]->nb_vertex = length(VECTOR_ELT(asp, 2));
+		as3d[i]->vertex = malloc(as3d[i]->nb_vertex*sizeof(double));
+		memcpy(as3d[i]->vertex, REAL(VECTOR_ELT(asp,2)), as3d[i]->nb_vertex*sizeof(double));
 	
-		as3d->nb_x = length(VECTOR_ELT(ret, 3));
-		as3d->x = malloc(as3d->nb_x*sizeof(double));
-		memcpy(as3d->x, REAL(VECTOR_ELT(ret,3)), as3d->nb_x*sizeof(double));
+		as3d[i]->nb_x = length(VECTOR_ELT(asp, 3));
+		as3d[i]->x = malloc(as3d[i]->nb_x*sizeof(double));
+		memcpy(as3d[i]->x, REAL(VECTOR_ELT(asp,3)), as3d[i]->nb_x*sizeof(double));
 
-		as3d->nb_alpha = length(VECTOR_ELT(ret, 4));
-		as3d->alpha = malloc(as3d->nb_alpha*sizeof(double));
-		memcpy(as3d->alpha, REAL(VECTOR_ELT(ret,4)), as3d->nb_alpha*sizeof(double));
+		as3d[i]->nb_alpha = length(VECTOR_ELT(asp, 4));
+		as3d[i]->alpha = malloc(as3d[i]->nb_alpha*sizeof(double));
+		memcpy(as3d[i]->alpha, REAL(VECTOR_ELT(asp,4)), as3d[i]->nb_alpha*sizeof(double));
 	}
 
 	UNPROTECT(3);
@@ -99,3 +111,5 @@ int* Cinashape3d(Ashape_t* as3d, double* points, int nb_points) {
 	UNPROTECT(5);
 	return LOGICAL(ret);
 }
+
+#endif
@@ -1,15 +1,16 @@
 #include "structure.h"
-#include "initialization.h"
-#include "expansion.h"
-#include "generation.h"
-#include "output.h"
 #include "util.h"
 #include "main.h"
-#include "assembly.h"
+#include "cagemol.h"
+#include "server.h"
+#include "batch.h"
+#include "checkpoint.h"
 
+#ifndef WITHOUT_R
 #include <R.h>
 #include <Rinternals.h>
 #include <Rembedded.h>
+#endif
 #include <libgen.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -21,17 +22,31 @@ int main(int argc, char** argv) {
 	time_t start = time(NULL);
 
 	/********************************* Options *****/
-	int opt;
-  Options_t options = { NULL, DEFLT_ALPHA, DEFLT_SIZEMAX, DEFLT_MAX_RESULTS };
+	int opt, i, status = EXIT_SUCCESS;
+  Options_t options = { NULL, NULL, 0, NULL, DEFLT_SIZEMAX, DEFLT_MAX_RESULTS, DEFLT_ENGINE, DEFLT_SEARCH, 0, 0, 0, NULL, 0, 0, NULL, NULL, NULL, NULL, NULL, 0, NULL, NULL };
+	struct option longOptions[] = {
+		{"search", required_argument, NULL, OPT_SEARCH},
+		{"deadline", required_argument, NULL, OPT_DEADLINE},
+		{"max-nodes", required_argument, NULL, OPT_MAX_NODES},
+		{"max-pair-nodes", required_argument, NULL, OPT_MAX_PAIR_NODES},
+		{"checkpoint", required_argument, NULL, OPT_CHECKPOINT},
+		{"checkpoint-interval", required_argument, NULL, OPT_CHECKPOINT_INTERVAL},
+		{"resume", no_argument, NULL, OPT_RESUME},
+		{"serve", required_argument, NULL, OPT_SERVE},
+		{"workers", required_argument, NULL, OPT_WORKERS},
+		{"batch", required_argument, NULL, OPT_BATCH},
+		{"cache", required_argument, NULL, OPT_CACHE},
+		{NULL, 0, NULL, 0}
+	};
 
-  while ((opt = getopt(argc, argv, OPTSTR)) != EOF) {
+  while ((opt = getopt_long(argc, argv, OPTSTR, longOptions, NULL)) != EOF) {
     switch(opt) {
       case 'i':
 				options.input = optarg;
         break;
 
 			case 'a':
-        options.alpha = atof(optarg);
+        parseAlphas(optarg, &options);
         break;
 
 			case 's':
@@ -42,6 +57,76 @@ int main(int argc, char** argv) {
         options.maxResults = atoi(optarg);
         break;
 
+			case 'e':
+				if (!strcmp(optarg, "r"))
+					options.engine = ENGINE_R;
+				else if (!strcmp(optarg, "native"))
+					options.engine = ENGINE_NATIVE;
+				else
+					usage();
+				break;
+
+			case OPT_SEARCH:
+				if (!strcmp(optarg, "dfs"))
+					options.search = SEARCH_DFS;
+				else if (!strcmp(optarg, "iddfs"))
+					options.search = SEARCH_IDDFS;
+				else if (!strcmp(optarg, "beam"))
+					options.search = SEARCH_BEAM;
+				else if (!strcmp(optarg, "astar"))
+					options.search = SEARCH_ASTAR;
+				else if (!strcmp(optarg, "bidir"))
+					options.search = SEARCH_BIDIR;
+				else
+					usage();
+				break;
+
+			case OPT_DEADLINE:
+				if (atof(optarg) <= 0)
+					usage();
+				options.deadline = omp_get_wtime() + atof(optarg);
+				break;
+
+			case OPT_MAX_NODES:
+				options.maxNodes = atol(optarg);
+				break;
+
+			case OPT_MAX_PAIR_NODES:
+				options.maxPairNodes = atol(optarg);
+				break;
+
+			case OPT_CHECKPOINT:
+				options.checkpoint = optarg;
+				break;
+
+			case OPT_CHECKPOINT_INTERVAL:
+				if (atof(optarg) <= 0)
+					usage();
+				options.checkpointInterval = atof(optarg);
+				break;
+
+			case OPT_RESUME:
+				options.resume = 1;
+				break;
+
+			case OPT_SERVE:
+				options.serve = optarg;
+				break;
+
+			case OPT_WORKERS:
+				if (atoi(optarg) <= 0)
+					usage();
+				options.workers = atoi(optarg);
+				break;
+
+			case OPT_BATCH:
+				options.batch = optarg;
+				break;
+
+			case OPT_CACHE:
+				options.cache = optarg;
+				break;
+
       case 'h':
       default:
         usage();
@@ -49,48 +134,110 @@ int main(int argc, char** argv) {
     }
 	}
 
-	if (options.input == NULL) {
+	if (options.input == NULL && options.serve == NULL && options.batch == NULL) {
 		fprintf(stderr, "Input filename .xyz of the substrate is missing.\n");
 		usage();
 		exit(EXIT_FAILURE);
 	}
 
+	if (options.checkpoint == NULL && (options.resume || options.checkpointInterval > 0)) {
+		fprintf(stderr, "The checkpoint file is missing.\n");
+		usage();
+	}
+
+	if (options.serve != NULL && (options.checkpoint != NULL || options.deadline > 0)) {
+		fprintf(stderr, "The checkpoint and the deadline are given by job with --serve.\n");
+		usage();
+	}
+
+	if (options.batch != NULL && (options.serve != NULL || options.checkpoint != NULL || options.input != NULL)) {
+		fprintf(stderr, "The substrates of --batch are given in the manifest (without checkpoint).\n");
+		usage();
+	}
+
+	if (options.checkpoint != NULL)
+		installCheckpointSignal();
+
+	if (options.serve != NULL && options.workers == 0)
+		options.workers = DEFLT_WORKERS;
+	if (options.workers > 1 && options.serve == NULL && options.checkpoint != NULL) {
+		fprintf(stderr, "The search shared by several workers cannot be checkpointed.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (options.nbAlphas == 0) {
+		options.alphas = malloc(sizeof(double));
+		options.alphas[options.nbAlphas++] = DEFLT_ALPHA;
+	}
+
+#ifdef WITHOUT_R
+	if (options.engine == ENGINE_R) {
+		fprintf(stderr, "The R engine is not available (compiled without R).\n");
+		exit(EXIT_FAILURE);
+	}
+#endif
+
 	/*********************************** Infos *****/
 
 	printf("\n####### Informations #######\n");
-	printf("  - Substrate : %s\n  - Alpha : %.1f\n  - Maximum size of a path (in atoms) : %d\n  - Maximum number of results : %d\n",
-					 options.input, options.alpha, options.sizeMax, options.maxResults);
-
-	Main_t* m = MN_create();
-	substrat(m) = initMolecule(options.input);
+	if (options.serve != NULL)
+		printf("  - Socket : %s\n  - Workers : %d\n  - Default parameters of the jobs\n", options.serve, options.workers);
+	else if (options.batch != NULL)
+		printf("  - Manifest : %s\n  - Default parameters of the jobs\n", options.batch);
+	else
+		printf("  - Substrate : %s\n", options.input);
+	printf("  - Alpha :");
+	for (i = 0; i < options.nbAlphas; i++)
+		printf(" %.1f", options.alphas[i]);
+	printf("\n  - Maximum size of a path (in atoms) : %d\n  - Maximum number of results : %d\n  - Envelope engine : %s\n  - Path search : %s\n",
+					 options.sizeMax, options.maxResults, ENGINE_NAME(options.engine), SEARCH_NAME(options.search));
 
 	/*************************************** R *****/
 
-	printf("\n####### R environment initialization #######\n");
+#ifndef WITHOUT_R
+	// R is not started if the pathless cages of every alpha value of the substrate are in the cache.
+	int withR = options.engine == ENGINE_R && (options.input == NULL || !CGM_isCached(options));
+	if (withR) {
+		printf("\n####### R environment initialization #######\n");
 	
-	int r_argc = 2;
-	char *r_argv [] = {"R", "--silent"};
+		int r_argc = 2;
+		char *r_argv [] = {"R", "--silent"};
 
-	setenv("R_HOME", "/usr/lib/R", 1);
-	Rf_initEmbeddedR(r_argc, r_argv);
+		setenv("R_HOME", "/usr/lib/R", 1);
+		Rf_initEmbeddedR(r_argc, r_argv);
+		source(PATHNAME);
+	}
+#endif
 
-	setWorkingDirectory("src");
-	source(PATHNAME);
+	if (options.serve != NULL)
+		serve(options.serve, options); // The R environment is shared by the jobs.
+	else if (options.batch != NULL)
+		runBatch(options.batch, options);
+	else {
+		/****************** Substrate and envelopes *****/
 
-	/*********** Envelope and binding patterns *****/
+		int error;
+		CageMol_t* context = CGM_create(options, &error);
 
-	envelope(m) = createShell(substrat(m), options.alpha);
-	generatePathlessCages(m);
+		if (context == NULL) {
+			fprintf(stderr, "The substrate %s could not be read : %s.\n", options.input, INPUT_ERROR_NAME(error));
+			status = EXIT_FAILURE;
+		}
+		else {
+			/***************************** Whole cages *****/
 
-	Rf_endEmbeddedR(0);
+			if (CGM_run(context, NULL, NULL) < 0) // The results are written in RESULTS_DIR.
+				status = EXIT_FAILURE;
 
-	/***************************** Whole cages *****/
+			CGM_delete(context);
+		}
+	}
 
-	writeMainOutput(options.input, m);
-	
-	generateWholeCages(m, options);
-	
-	MN_delete(m);
+#ifndef WITHOUT_R
+	if (withR)
+		Rf_endEmbeddedR(0);
+#endif
+	free(options.alphas);
 
 	/************************************ Time *****/
 		
@@ -103,14 +250,36 @@ int main(int argc, char** argv) {
 	seconds -= minutes * 60;
 	printf("\nExecution time : %d hour(s) %d minute(s) %ld second(s)\n", hours, minutes, seconds);
 	
-	return EXIT_SUCCESS;
+	return status;
+}
+
+/**
+ * Parsing of the alpha values given as a list separated by commas.
+ *
+ * @param arg String of the option (for instance 2.5,3,3.5).
+ * @param options Options where the alpha values are added.
+ */
+void parseAlphas(char* arg, Options_t* options) {
+	char* token;
+
+	for (token = strtok(arg, ","); token != NULL; token = strtok(NULL, ",")) {
+		options->alphas = realloc(options->alphas, (options->nbAlphas+1)*sizeof(double));
+		options->alphas[options->nbAlphas] = atof(token);
+
+		if (options->alphas[options->nbAlphas] <= 0) {
+			fprintf(stderr, "Invalid alpha value : %s.\n", token);
+			usage();
+		}
+		options->nbAlphas++;
+	}
 }
 
 void usage() {
-	fprintf(stderr, USAGE_FMT, DEFLT_ALPHA, DEFLT_SIZEMAX, DEFLT_MAX_RESULTS);
+	fprintf(stderr, USAGE_FMT, DEFLT_ALPHA, DEFLT_SIZEMAX, DEFLT_MAX_RESULTS, ENGINE_NAME(DEFLT_ENGINE), SEARCH_NAME(DEFLT_SEARCH), DEFLT_WORKERS);
 	exit(EXIT_FAILURE);
 }
 
+#ifndef WITHOUT_R
 void source(const char* name) {
 	SEXP e;
 	int errorOccurred;
@@ -125,16 +294,4 @@ void source(const char* name) {
   UNPROTECT(1);
 }
 
-void setWorkingDirectory(char* dir) {
-	SEXP e;
-	int errorOccurred;
-
-	PROTECT(e = lang2(install("setwd"), mkString(dir)));
-  R_tryEval(e, R_GlobalEnv, &errorOccurred);
-
-	if (errorOccurred) {
-		fprintf(stderr, "An error occurred while using R.\n");
-		exit(EXIT_FAILURE);
-  }
-  UNPROTECT(1);
-}
+#endif
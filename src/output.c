@@ -7,19 +7,19 @@
 
 /**
 */
-char* createDir(char *input) {
-  char* dirName = malloc (256 * sizeof(char));
+char* createDir(char* results, char *input) {
+  char* dirName = malloc (strlen(results) + 256 * sizeof(char));
   
-  mkdir("../results", 0755);
-  sprintf(dirName,"../results/%s",input);
+  mkdir(results, 0755);
+  sprintf(dirName,"%s/%s",results,input);
   mkdir(dirName,0755);
 
   return dirName;
 }
 
-char* createUnderDir(char *input, int nbmotif) {
-  char* dirName = malloc (256 * sizeof(char));
-  sprintf(dirName,"../results/%s/%d",input, nbmotif);
+char* createUnderDir(char* results, char *input, int nbmotif) {
+  char* dirName = malloc (strlen(results) + 256 * sizeof(char));
+  sprintf(dirName,"%s/%s/%d",results,input, nbmotif);
   mkdir(dirName,0755);
 
   return dirName;
@@ -33,8 +33,10 @@ char* getBasename(char * in) {
   int i;
 
   start = strrchr(in, '/');
+  if (start == NULL) // File of the working directory.
+    start = in - 1;
 
-  for (i=0; start[i+1] != '.'; ++i) {
+  for (i=0; start[i+1] != '.' && start[i+1] != '\0'; ++i) {
     r[i] = start[i+1];
   }
   r[i] = '\0';
@@ -187,19 +189,17 @@ void MOL_writeMol2(char* output, Molecule_t* m) {
   fclose(filestream);
 }
 
-void SHL_writeMol2(char* output, Shell_t* s) {
-  FILE* filestream = NULL;
+/**
+ * Write a shell in the mol2 format in an open stream (a file or a socket).
+ *
+ * @param filestream Stream.
+ * @param s Shell.
+ * @return (int) Negative if an error occured.
+ */
+int SHL_printMol2(FILE* filestream, Shell_t* s) {
   int ret, i, j, l;
   int* index = malloc(size(s)*sizeof(int));
 
-  filestream = fopen(output, "w");
-  if (filestream == NULL)
-  {
-	  printf("Th file %s could not be open for writting.\n", output);
-	  if(index) free(index);
-	  return;
-  }
-  
   ret = fprintf(filestream, "@<TRIPOS>MOLECULE\n*****\n");
   ret = fprintf(filestream, " %d %d 0 0 0\n", SHL_nbAtom(s), SHL_nbEdges(s));
   ret = fprintf(filestream, "SMALL\nGASTEIGER\n\n");
@@ -270,35 +270,46 @@ void SHL_writeMol2(char* output, Shell_t* s) {
         l++;
       }
 
-  if (ret<0) {
+  free(index);
+  return ret;
+}
+
+void SHL_writeMol2(char* output, Shell_t* s) {
+  FILE* filestream = NULL;
+
+  filestream = fopen(output, "w");
+  if (filestream == NULL)
+  {
+	  printf("Th file %s could not be open for writting.\n", output);
+	  return;
+  }
+
+  if (SHL_printMol2(filestream, s) < 0) {
     printf("Writting of file %s did not go well.\n", output);
     exit(2);
   }
 
-  free(index);
   fclose(filestream);
 }
 
-void writeShellOutput(char* inputFile, Shell_t* s, int tailleMocInit) {
-	char outputname[512];
-	char* name = getBasename (inputFile);
-	createDir(name);
+// The index of the result is given by the caller (shared by the threads, and kept in the checkpoints).
+void writeShellOutput(char* results, char* name, Shell_t* s, int tailleMocInit, int i) {
+	char* outputname;
+	free(createDir(results, name));
   int nbmotif = SHL_nbAtom(s) - tailleMocInit;
-  char* dirName = createUnderDir(name, nbmotif);
-	static int i = 0;
+  char* dirName = createUnderDir(results, name, nbmotif);
 	
+	outputname = malloc(strlen(dirName) + 512);
 	sprintf(outputname, "%s/%s_mot%d.mol2", dirName, name, i);
 	SHL_writeMol2(outputname, s);
 	printf("Result : %d\n", i);
-	free(name);
+	free(outputname);
 	free(dirName);
-	i++;
 }
 
-void writeMainOutput(char* inputFile, Main_t* m) {
-  char outputname[512];
-  char* name = getBasename (inputFile);
-  char* dirName = createDir(name);
+void writeMainOutput(char* results, char* name, Main_t* m) {
+  char* dirName = createDir(results, name);
+  char* outputname = malloc(strlen(dirName) + 512);
 
   printf("\n####### Writing the substrate and the envelope in the result files #######\n");
 
@@ -314,6 +325,6 @@ void writeMainOutput(char* inputFile, Main_t* m) {
   sprintf(outputname, "%s/%s_moc%d.mol2", dirName, name, 0);
   SHL_writeMol2(outputname, moc(m,0));
 
-  free(name);
+  free(outputname);
   free(dirName);
 }
@@ -0,0 +1,268 @@
+#include "server.h"
+#include "cagemol.h"
+#include "input.h"
+#include "output.h"
+#include "constant.h"
+#include <signal.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+/**************************************/
+/* SERVER *****************************/
+/**************************************/
+
+// A job is a line of parameters (key=value, the others are those of the server), then the content of a .xyz file.
+// Each connected cage is sent as "CAGE index" followed by its mol2 text, then "END number of results",
+// or "ERROR message" if the job is invalid.
+
+static volatile sig_atomic_t serverStopped = 0;
+
+static void stopHandler(int sig) {
+
+	serverStopped = 1;
+}
+
+/**
+ * Result callback of a job: the cage is sent to the client.
+ *
+ * @param s Connected cage.
+ * @param index Index of the result.
+ * @param data Stream of the client.
+ * @return (int) Nonzero if the client is gone (the search stops).
+ */
+static int sendCage(Shell_t* s, int index, void* data) {
+
+	FILE* out = data;
+
+	fprintf(out, "CAGE %d\n", index);
+	SHL_printMol2(out, s);
+	fflush(out);
+
+	return ferror(out);
+}
+
+/**
+ * Read the parameters of a job.
+ *
+ * @param line Parameters (alpha=a1,a2,... sizemax=n results=n search=name deadline=seconds nodes=n pairnodes=n).
+ * @param options Options of the job (the alpha values given are allocated).
+ * @return (char*) Error message, NULL if the parameters are valid.
+ */
+static char* readParameters(char* line, Options_t* options) {
+
+	char *token, *value, *alpha, *save, *saveAlpha;
+
+	for (token = strtok_r(line, " \t\r\n", &save); token != NULL; token = strtok_r(NULL, " \t\r\n", &save)) {
+		value = strchr(token, '=');
+		if (value == NULL)
+			return "parameter without value";
+		*value++ = '\0';
+
+		if (!strcmp(token, "alpha")) {
+			for (alpha = strtok_r(value, ",", &saveAlpha); alpha != NULL; alpha = strtok_r(NULL, ",", &saveAlpha)) {
+				options->alphas = realloc(options->alphas, (options->nbAlphas+1)*sizeof(double));
+				if ((options->alphas[options->nbAlphas++] = atof(alpha)) <= 0)
+					return "invalid alpha value";
+			}
+		}
+		else if (!strcmp(token, "sizemax"))
+			options->sizeMax = atoi(value);
+		else if (!strcmp(token, "results"))
+			options->maxResults = atoi(value);
+		else if (!strcmp(token, "search")) {
+			for (options->search = 0; options->search <= SEARCH_IDDFS && strcmp(SEARCH_NAME(options->search), value); options->search++);
+			if (options->search > SEARCH_IDDFS)
+				return "unknown search";
+		}
+		else if (!strcmp(token, "deadline"))
+			options->deadline = omp_get_wtime() + atof(value);
+		else if (!strcmp(token, "nodes"))
+			options->maxNodes = atol(value);
+		else if (!strcmp(token, "pairnodes"))
+			options->maxPairNodes = atol(value);
+		else
+			return "unknown parameter";
+	}
+
+	if (options->sizeMax <= 0 || options->maxResults <= 0)
+		return "invalid sizemax or results";
+
+	return NULL;
+}
+
+/**
+ * Copy the substrate of a job in a .xyz file: the number of atoms, then a line per atom
+ * (the atoms are checked when the file is read).
+ *
+ * @param in Stream of the client.
+ * @param f File of the substrate.
+ * @return (char*) Error message, NULL if the substrate is complete.
+ */
+static char* readSubstrate(FILE* in, FILE* f) {
+
+	char line[SERVER_LINE_SIZE];
+	int i, nbAtoms;
+
+	if (!fgets(line, SERVER_LINE_SIZE, in) || sscanf(line, "%d", &nbAtoms) != 1 || nbAtoms <= 0)
+		return "invalid number of atoms";
+	fprintf(f, "%d\n\n", nbAtoms);
+
+	for (i = 0; i < nbAtoms; ) {
+		if (!fgets(line, SERVER_LINE_SIZE, in))
+			return "truncated substrate";
+		if (strspn(line, " \t\r\n") < strlen(line)) { // The empty lines (comment of the .xyz) are skipped.
+			fputs(line, f);
+			i++;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Process a job: its cages are streamed to the client.
+ *
+ * @param fd Connection of the client (closed).
+ * @param options Options of the server.
+ */
+static void processJob(int fd, Options_t options) {
+
+	char line[SERVER_LINE_SIZE], file[] = SERVER_SUBSTRATE;
+	char* error = "empty job";
+	int tmp;
+	FILE* in = fdopen(fd, "r");
+	FILE* out = fdopen(dup(fd), "w");
+	Options_t job = options;
+
+	job.alphas = NULL;
+	job.nbAlphas = 0;
+	if (fgets(line, SERVER_LINE_SIZE, in))
+		error = readParameters(line, &job);
+	if (job.nbAlphas == 0) { // Alpha values of the server.
+		job.alphas = options.alphas;
+		job.nbAlphas = options.nbAlphas;
+	}
+
+	if (error == NULL) {
+		if ((tmp = mkstemp(file)) < 0) {
+			file[0] = '\0';
+			error = "temporary file";
+		}
+		else {
+			FILE* f = fdopen(tmp, "w");
+			error = readSubstrate(in, f);
+			fclose(f);
+		}
+	}
+
+	if (error != NULL)
+		fprintf(out, "ERROR %s\n", error);
+	else {
+		CageMol_t* c;
+		int nbResults, inputError;
+
+		job.input = file;
+		if ((c = CGM_create(job, &inputError)) == NULL)
+			fprintf(out, "ERROR %s\n", INPUT_ERROR_NAME(inputError));
+		else {
+			nbResults = CGM_run(c, sendCage, out);
+			CGM_delete(c);
+			fprintf(out, "END %d\n", nbResults);
+		}
+	}
+
+	if (file[0] != '\0')
+		unlink(file);
+	if (job.alphas != options.alphas)
+		free(job.alphas);
+	fclose(in);
+	fclose(out);
+}
+
+/**
+ * Start a worker: it processes the jobs of the socket until it is killed.
+ *
+ * @param server Listening socket.
+ * @param options Options of the server.
+ * @param nbThreads Number of threads of the search of a job.
+ * @return (pid_t) Process of the worker.
+ */
+static pid_t startWorker(int server, Options_t options, int nbThreads) {
+
+	pid_t pid;
+
+	fflush(stdout);
+	if ((pid = fork()) != 0)
+		return pid;
+
+	signal(SIGTERM, SIG_DFL);
+	signal(SIGINT, SIG_DFL);
+	signal(SIGPIPE, SIG_IGN); // A client gone is seen when the cages are sent.
+	omp_set_num_threads(nbThreads);
+
+	while (1) {
+		int fd = accept(server, NULL, NULL);
+
+		if (fd >= 0)
+			processJob(fd, options);
+	}
+}
+
+/**
+ * Serve the jobs sent on a Unix domain socket until SIGTERM or SIGINT.
+ * The workers are forked once the envelope engine is initialized and the covalent radii are read
+ * (R, its script and the table of the radii are kept warm).
+ *
+ * @param path Path of the socket.
+ * @param options Options of the server (the default parameters of the jobs, and the number of workers).
+ */
+void serve(char* path, Options_t options) {
+
+	struct sockaddr_un address;
+	struct sigaction action;
+	int i, server, nbThreads;
+	pid_t* workers;
+
+	if (strlen(path) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "The path of the socket %s is too long.\n", path);
+		exit(EXIT_FAILURE);
+	}
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+	unlink(path);
+
+	server = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server < 0 || bind(server, (struct sockaddr*)&address, sizeof(address)) || listen(server, SERVER_BACKLOG)) {
+		fprintf(stderr, "The socket %s could not be open.\n", path);
+		exit(EXIT_FAILURE);
+	}
+
+	if (readRadii(options.radii != NULL ? options.radii : RDC_FILE) != INPUT_OK)
+		exit(EXIT_FAILURE);
+
+	// Without SA_RESTART, wait is interrupted by the signal.
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = stopHandler;
+	sigaction(SIGTERM, &action, NULL);
+	sigaction(SIGINT, &action, NULL);
+
+	nbThreads = omp_get_num_procs() / options.workers > 0 ? omp_get_num_procs() / options.workers : 1;
+	printf("\n####### Serving on %s : %d workers of %d threads #######\n", path, options.workers, nbThreads);
+	workers = malloc(options.workers*sizeof(pid_t));
+	for (i = 0; i < options.workers; i++)
+		workers[i] = startWorker(server, options, nbThreads);
+
+	while (!serverStopped && (wait(NULL) > 0 || errno == EINTR));
+
+	for (i = 0; i < options.workers; i++)
+		kill(workers[i], SIGTERM);
+	while (wait(NULL) > 0);
+
+	close(server);
+	unlink(path);
+	free(workers);
+}
@@ -0,0 +1,212 @@
+#include "shard.h"
+#include "output.h"
+#include "constant.h"
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**************************************/
+/* SHARDED SEARCH *********************/
+/**************************************/
+
+// The frontier of the cages with one path is shared between processes:
+// each worker searches its share and spools its results, the parent merges them.
+struct Spool {
+
+	char* dir; // Directory of the spooled results.
+	FILE* index; // A line by result : index, number of patterns, fingerprint.
+	int shard;
+};
+
+/**
+ * Fork the workers of a sharded search.
+ * A worker is single threaded (the threads of OpenMP cannot be used after a fork).
+ *
+ * @param nbShards Number of workers.
+ * @param shard Set to the index of the worker in a worker, to -1 in the parent.
+ * @return (pid_t*) Processes of the workers in the parent, NULL in a worker.
+ */
+pid_t* forkShards(int nbShards, int* shard) {
+
+	int i;
+	pid_t* pids = malloc(nbShards*sizeof(pid_t));
+
+	fflush(stdout);
+	for (i = 0; i < nbShards; i++) {
+		if ((pids[i] = fork()) == 0) {
+			free(pids);
+			*shard = i;
+			omp_set_num_threads(1);
+			return NULL;
+		}
+		if (pids[i] < 0) {
+			perror("fork");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	*shard = -1;
+	return pids;
+}
+
+/**
+ * Keep the share of the frontier of a worker.
+ * A cage of the frontier goes to the worker whose index is its key modulo the number of workers
+ * (the cages found below it by several workers are merged once).
+ *
+ * @param d Deque of the frontier (its items are kept in the same order).
+ * @param shard Index of the worker.
+ * @param nbShards Number of workers.
+ * @param pending Set to the number of kept items.
+ */
+void keepShard(Deque_t* d, int shard, int nbShards, int* pending) {
+
+	int i, nbKept = 0;
+	Work_t* w;
+	Work_t** kept = NULL;
+
+	while ((w = DEQ_pop(d)) != NULL) {
+		if (TBL_mix(TBL_fingerprint(w->moc)) % nbShards == (unsigned long)shard) {
+			kept = realloc(kept, (nbKept + 1)*sizeof(Work_t*));
+			kept[nbKept++] = w;
+		}
+		else
+			WRK_delete(w);
+	}
+	for (i = nbKept - 1; i >= 0; i--) // The first item is popped first.
+		DEQ_push(d, kept[i]);
+
+	free(kept);
+	*pending = nbKept;
+}
+
+/**
+ * Create the spool of the results of a worker.
+ *
+ * @param results Directory of the results.
+ * @param output Name of the results of the substrate.
+ * @param shard Index of the worker.
+ */
+Spool_t* SPL_create(char* results, char* output, int shard) {
+
+	Spool_t* s = malloc(sizeof(Spool_t));
+	char* file;
+
+	free(createDir(results, output));
+	s->dir = malloc(strlen(results) + strlen(output) + 64);
+	sprintf(s->dir, SHARD_SPOOL, results, output, shard);
+	mkdir(s->dir, 0755);
+
+	file = malloc(strlen(s->dir) + 64);
+	sprintf(file, "%s/index", s->dir);
+	if ((s->index = fopen(file, "w")) == NULL) {
+		perror(file);
+		exit(EXIT_FAILURE);
+	}
+	free(file);
+
+	s->shard = shard;
+
+	return s;
+}
+
+/**
+ * Write a result of a worker in its spool (instead of the results of the substrate).
+ *
+ * @param s Spool of the worker.
+ * @param cage Connected cage.
+ * @param n Index of the result in the worker.
+ * @param nbMotifs Number of atoms added to its pathless cage.
+ */
+void spoolResult(Spool_t* s, Shell_t* cage, int n, int nbMotifs) {
+
+	char* file = malloc(strlen(s->dir) + 64);
+
+	sprintf(file, "%s/%d.mol2", s->dir, n);
+	SHL_writeMol2(file, cage);
+	fprintf(s->index, "%d %d %lx\n", n, nbMotifs, TBL_mix(TBL_fingerprint(cage)));
+
+	free(file);
+}
+
+/**
+ * End a worker once its share is searched (the parent merges its spool).
+ *
+ * @param s Spool of the worker.
+ * @param m Grouping of the main structures (budget of the worker).
+ * @param nbResults Number of results of the worker.
+ */
+void exitShard(Spool_t* s, Main_t* m, int nbResults) {
+
+	fclose(s->index);
+	printf("  - Worker %d : %d results, %ld explored subtrees\n", s->shard, nbResults, m->budget.nbNodes);
+	fflush(stdout);
+	_exit(EXIT_SUCCESS);
+}
+
+/**
+ * Merge the spools of the workers in the results of the substrate, once they are ended.
+ * The results are renumbered in the order of the workers, and the cages found by several workers
+ * (the same paths added in a different order) are kept once.
+ *
+ * @param results Directory of the results.
+ * @param output Name of the results of the substrate.
+ * @param pids Processes of the workers (freed).
+ * @param nbShards Number of workers.
+ * @param countResults Number of results written before the workers.
+ * @param maxResults Maximum number of results.
+ * @return (int) Number of results.
+ */
+int mergeShards(char* results, char* output, pid_t* pids, int nbShards, int countResults, int maxResults) {
+
+	int i, n, nbMotifs, status, nbDuplicates = 0;
+	unsigned long key;
+	char* dir = malloc(strlen(results) + strlen(output) + 64);
+	char* file = malloc(strlen(results) + strlen(output) + 128);
+	char* name = malloc(strlen(results) + 2*strlen(output) + 512);
+	Table_t* cages = TBL_create(TABLE_SIZE);
+
+	for (i = 0; i < nbShards; i++) {
+		FILE* index;
+
+		waitpid(pids[i], &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+			fprintf(stderr, "The worker %d of the search failed, its spooled results are merged.\n", i);
+
+		sprintf(dir, SHARD_SPOOL, results, output, i);
+		sprintf(file, "%s/index", dir);
+		if ((index = fopen(file, "r")) == NULL)
+			continue;
+		while (fscanf(index, "%d %d %lx", &n, &nbMotifs, &key) == 3) {
+			sprintf(file, "%s/%d.mol2", dir, n);
+			if (countResults >= maxResults)
+				remove(file);
+			else if (TBL_checkAndInsert(cages, key)) {
+				nbDuplicates++;
+				remove(file);
+			}
+			else {
+				char* underDir = createUnderDir(results, output, nbMotifs);
+				sprintf(name, "%s/%s_mot%d.mol2", underDir, output, countResults);
+				rename(file, name);
+				printf("Result : %d\n", countResults++);
+				free(underDir);
+			}
+		}
+		fclose(index);
+		sprintf(file, "%s/index", dir);
+		remove(file);
+		rmdir(dir);
+	}
+	printf("  - Merged results of %d workers : %d (%d duplicated cages)\n", nbShards, countResults, nbDuplicates);
+
+	TBL_delete(cages);
+	free(pids);
+	free(name);
+	free(file);
+	free(dir);
+	return countResults;
+}
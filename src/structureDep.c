@@ -0,0 +1,186 @@
+#include "structure.h"
+
+/**************************************/
+/* DEPENDENCIES ***********************/
+/**************************************/
+
+#define WORD_BITS (8*sizeof(unsigned long))
+#define frame(d,k) ((d)->frames + 4*(k)*(d)->nbWords)
+#define conflicts(d,v) ((d)->conflicts + (v)*(d)->nbWords)
+
+static void DEP_add(unsigned long* set, int v) {
+
+	set[v / WORD_BITS] |= 1UL << (v % WORD_BITS);
+}
+
+static void DEP_remove(unsigned long* set, int v) {
+
+	set[v / WORD_BITS] &= ~(1UL << (v % WORD_BITS));
+}
+
+/**
+ * Check if a vertex is in a set.
+ *
+ * @param d Dependencies.
+ * @param set Set of vertices.
+ * @param v Vertex.
+ * @return (int) 1 if the vertex is in the set, 0 otherwise.
+ */
+int DEP_check(Dependencies_t* d, unsigned long* set, int v) {
+
+	return (set[v / WORD_BITS] >> (v % WORD_BITS)) & 1;
+}
+
+/**
+ * First vertex of a set, -1 if it is empty.
+ */
+static int DEP_first(Dependencies_t* d, unsigned long* set) {
+
+	int w;
+
+	for (w = 0; w < d->nbWords; w++)
+		if (set[w])
+			return w*WORD_BITS + __builtin_ctzl(set[w]);
+
+	return -1;
+}
+
+/**
+ * Candidates of a frame: the candidates incompatible with the pivot, or the pivot.
+ * The pivot is the vertex of the candidates or of the excluded ones that leaves the fewest candidates
+ * (the sets built from a vertex compatible with the pivot are built from the pivot too, or are not maximal).
+ *
+ * @param d Dependencies.
+ * @param f Frame (its candidates left are set).
+ */
+static void DEP_branch(Dependencies_t* d, unsigned long* f) {
+
+	unsigned long *P = f + d->nbWords, *X = f + 2*d->nbWords, *C = f + 3*d->nbWords;
+	int w, v, nb, best = -1, min = d->nbVertices + 1;
+
+	for (v = 0; v < d->nbVertices; v++)
+		if (DEP_check(d, P, v) || DEP_check(d, X, v)) {
+			for (w = 0, nb = DEP_check(d, P, v); w < d->nbWords; w++)
+				nb += __builtin_popcountl(P[w] & conflicts(d,v)[w]);
+			if (nb < min) {
+				min = nb;
+				best = v;
+			}
+		}
+
+	for (w = 0; w < d->nbWords; w++)
+		C[w] = (best == -1) ? 0 : P[w] & conflicts(d,best)[w];
+	if (best != -1 && DEP_check(d, P, best))
+		DEP_add(C, best);
+}
+
+/**
+ * Next maximal set of compatible vertices (no conflict between its vertices, and every other vertex conflicts with one of them).
+ * The sets are enumerated once each, in the same order for the same graph.
+ *
+ * @param d Dependencies.
+ * @return (unsigned long*) Set of vertices (valid until the next call), NULL once every set is enumerated.
+ */
+unsigned long* DEP_next(Dependencies_t* d) {
+
+	int w, v, empty;
+
+	if (d->nbVertices == 0 && d->depth == 0) { // The empty set is the only one.
+		d->depth = -1;
+		d->nbSets++;
+		return frame(d,1);
+	}
+
+	while (d->depth >= 0) {
+		unsigned long *f = frame(d, d->depth), *g = frame(d, d->depth + 1);
+		unsigned long *P = f + d->nbWords, *X = f + 2*d->nbWords, *C = f + 3*d->nbWords;
+
+		if ((v = DEP_first(d, C)) == -1) { // Every candidate of the frame is tried.
+			d->depth--;
+			continue;
+		}
+		DEP_remove(C, v);
+
+		// The vertex is added to the set, the other candidates and excluded vertices must be compatible with it.
+		for (w = 0; w < d->nbWords; w++) {
+			g[w] = f[w];
+			g[w + d->nbWords] = P[w] & ~conflicts(d,v)[w];
+			g[w + 2*d->nbWords] = X[w] & ~conflicts(d,v)[w];
+		}
+		DEP_add(g, v);
+		DEP_remove(g + d->nbWords, v);
+		DEP_remove(g + 2*d->nbWords, v);
+		DEP_remove(P, v);
+		DEP_add(X, v);
+
+		if (DEP_first(d, g + d->nbWords) != -1) {
+			DEP_branch(d, g);
+			d->depth++;
+			continue;
+		}
+		// No candidate left: the set is maximal if no excluded vertex can be added.
+		for (w = 0, empty = 1; w < d->nbWords; w++)
+			if (g[w + 2*d->nbWords])
+				empty = 0;
+		if (empty) {
+			d->nbSets++;
+			return g;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Creation of the dependencies of a graph: two vertices linked by an edge are in conflict.
+ *
+ * @param g Dependency graph (the vertices of id -1 are ignored).
+ * @return (Dependencies_t*) Dependencies, the enumeration starts from the first set.
+ */
+Dependencies_t* DEP_create(Graph_t* g) {
+
+	int i, j, k;
+	Dependencies_t* d = malloc(sizeof(Dependencies_t));
+	int* index = malloc((size(g) + 1)*sizeof(int)); // Vertex of each slot of the graph.
+
+	d->ids = malloc((size(g) + 1)*sizeof(int));
+	d->nbVertices = 0;
+	for (i = 0; i < size(g); i++) {
+		index[i] = -1;
+		if (id(vertex(g,i)) != -1) {
+			index[i] = d->nbVertices;
+			d->ids[d->nbVertices++] = id(vertex(g,i));
+		}
+	}
+	d->nbWords = d->nbVertices / WORD_BITS + 1;
+
+	d->conflicts = calloc(d->nbVertices * d->nbWords, sizeof(unsigned long));
+	for (i = 0; i < size(g); i++)
+		if (index[i] != -1)
+			for (j = 0; j < nbNeighbors(vertex(g,i)); j++)
+				if ((k = GPH_getIndice(g, neighbor(vertex(g,i), j))) != -1 && index[k] != -1) {
+					DEP_add(conflicts(d, index[i]), index[k]);
+					DEP_add(conflicts(d, index[k]), index[i]);
+				}
+	free(index);
+
+	// Every vertex is a candidate of the first frame.
+	d->frames = calloc(4 * (d->nbVertices + 2) * d->nbWords, sizeof(unsigned long));
+	for (i = 0; i < d->nbVertices; i++)
+		DEP_add(frame(d,0) + d->nbWords, i);
+	DEP_branch(d, frame(d,0));
+	d->depth = 0;
+	d->nbSets = 0;
+
+	return d;
+}
+
+void DEP_delete(Dependencies_t* d) {
+
+	if (d != NULL) {
+		free(d->ids);
+		free(d->conflicts);
+		free(d->frames);
+	}
+	free(d);
+}
@@ -0,0 +1,237 @@
+#include "structure.h"
+
+/**************************************/
+/* WORK-STEALING **********************/
+/**************************************/
+
+/**
+ * Allocate a work item.
+ *
+ * @param moc Partial cage (owned by the item).
+ * @param start, end Pair of atoms to connect (-1 for a cage whose pairs are not chosen).
+ * @param group Group of the pairs of the same cage (NULL for a cage).
+ * @param index Index of the pair in its group.
+ */
+Work_t* WRK_create(Shell_t* moc, int start, int end, Group_t* group, int index) {
+
+	Work_t* w = malloc(sizeof(Work_t));
+
+	w->moc = moc;
+	w->start = start;
+	w->end = end;
+	w->group = group;
+	w->index = index;
+	w->components = NULL;
+	w->resumed = 0;
+	w->pathlessSize = 0;
+
+	return w;
+}
+
+/**
+ * Delete a work item.
+ * The group of a pair is deleted with its last pair.
+ */
+void WRK_delete(Work_t* w) {
+
+	if (w->moc != NULL)
+		SHL_delete(w->moc);
+	PRT_delete(w->components);
+	if (w->group != NULL) {
+		int remaining;
+		#pragma omp atomic capture
+		remaining = --w->group->remaining;
+		if (remaining == 0)
+			GRP_delete(w->group);
+	}
+	free(w);
+}
+
+/**
+ * Allocate the group of the pairs of a cage.
+ *
+ * @param moc Cage to connect (owned by the group).
+ * @param components Connected components of the cage (owned by the group).
+ * @param nbPairs Number of pairs (work items) of the cage.
+ */
+Group_t* GRP_create(Shell_t* moc, Partition_t* components, int nbPairs) {
+
+	int i;
+	Group_t* g = malloc(sizeof(Group_t));
+
+	g->moc = moc;
+	g->components = components;
+	g->results = malloc(nbPairs*sizeof(List_m*));
+	g->starts = malloc(nbPairs*sizeof(int));
+	g->ends = malloc(nbPairs*sizeof(int));
+	for (i=0; i<nbPairs; i++)
+		g->results[i] = NULL;
+	g->nbPairs = nbPairs;
+	g->remaining = nbPairs;
+	g->interrupted = 0;
+	g->pathlessSize = 0;
+
+	return g;
+}
+
+void GRP_delete(Group_t* g) {
+
+	int i;
+
+	for (i=0; i<g->nbPairs; i++)
+		if (g->results[i] != NULL)
+			LSTm_delete(g->results[i]);
+	free(g->results);
+	free(g->starts);
+	free(g->ends);
+	SHL_delete(g->moc);
+	PRT_delete(g->components);
+	free(g);
+}
+
+Deque_t* DEQ_create() {
+
+	Deque_t* d = malloc(sizeof(Deque_t));
+
+	d->items = NULL;
+	d->top = 0;
+	d->bottom = 0;
+	size(d) = 0;
+	omp_init_lock(&d->lock);
+
+	return d;
+}
+
+void DEQ_delete(Deque_t* d) {
+
+	while (d->bottom > d->top)
+		WRK_delete(d->items[--d->bottom]);
+	omp_destroy_lock(&d->lock);
+	free(d->items);
+	free(d);
+}
+
+/**
+ * Push a work item at the bottom of the deque (by its owner).
+ */
+void DEQ_push(Deque_t* d, Work_t* w) {
+
+	omp_set_lock(&d->lock);
+
+	if (d->bottom == size(d)) {
+		if (d->top > 0) { // Reuse the space of the stolen items.
+			memmove(d->items, d->items + d->top, (d->bottom - d->top)*sizeof(Work_t*));
+			d->bottom -= d->top;
+			d->top = 0;
+		}
+		else {
+			size(d) += DEQUE_SIZE;
+			d->items = realloc(d->items, size(d)*sizeof(Work_t*));
+		}
+	}
+	d->items[d->bottom++] = w;
+
+	omp_unset_lock(&d->lock);
+}
+
+/**
+ * Pop the last pushed work item (by the owner of the deque).
+ *
+ * @return (Work_t*) Work item, NULL if the deque is empty.
+ */
+Work_t* DEQ_pop(Deque_t* d) {
+
+	Work_t* w = NULL;
+
+	omp_set_lock(&d->lock);
+	if (d->bottom > d->top)
+		w = d->items[--d->bottom];
+	if (d->bottom == d->top)
+		d->bottom = d->top = 0;
+	omp_unset_lock(&d->lock);
+
+	return w;
+}
+
+/**
+ * Steal the oldest work item of the deque (by another thread).
+ *
+ * @return (Work_t*) Work item, NULL if the deque is empty.
+ */
+Work_t* DEQ_steal(Deque_t* d) {
+
+	Work_t* w = NULL;
+
+	omp_set_lock(&d->lock);
+	if (d->bottom > d->top)
+		w = d->items[d->top++];
+	if (d->bottom == d->top)
+		d->bottom = d->top = 0;
+	omp_unset_lock(&d->lock);
+
+	return w;
+}
+
+/**
+ * Allocate the idle threads of a search.
+ */
+Idle_t* IDL_create() {
+
+	Idle_t* idle = malloc(sizeof(Idle_t));
+
+	idle->epoch = 0;
+	idle->nbIdle = 0;
+	pthread_mutex_init(&idle->lock, NULL);
+	pthread_cond_init(&idle->changed, NULL);
+
+	return idle;
+}
+
+void IDL_delete(Idle_t* idle) {
+
+	pthread_mutex_destroy(&idle->lock);
+	pthread_cond_destroy(&idle->changed);
+	free(idle);
+}
+
+/**
+ * Number of changes of the frontier, read before a thread looks for work.
+ */
+long IDL_epoch(Idle_t* idle) {
+
+	long epoch;
+
+	pthread_mutex_lock(&idle->lock);
+	epoch = idle->epoch;
+	pthread_mutex_unlock(&idle->lock);
+
+	return epoch;
+}
+
+/**
+ * Sleep until the frontier changes (at once if it changed since the thread looked for work).
+ *
+ * @param idle Idle threads.
+ * @param epoch Number of changes read before the thread looked for work.
+ */
+void IDL_wait(Idle_t* idle, long epoch) {
+
+	pthread_mutex_lock(&idle->lock);
+	idle->nbIdle++;
+	while (idle->epoch == epoch)
+		pthread_cond_wait(&idle->changed, &idle->lock);
+	idle->nbIdle--;
+	pthread_mutex_unlock(&idle->lock);
+}
+
+/**
+ * Wake the idle threads: the frontier changed.
+ */
+void IDL_notify(Idle_t* idle) {
+
+	pthread_mutex_lock(&idle->lock);
+	idle->epoch++;
+	if (idle->nbIdle > 0)
+		pthread_cond_broadcast(&idle->changed);
+	pthread_mutex_unlock(&idle->lock);
+}
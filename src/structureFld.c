@@ -0,0 +1,111 @@
+#include "structure.h"
+#include "util.h"
+#include <math.h>
+#include <float.h>
+
+/**************************************/
+/* FIELD ******************************/
+/**************************************/
+
+#define voxel(f,x,y,z) (f)->voxels[((z)*(f)->ny + (y))*(f)->nx + (x)]
+
+/**
+ * Index of the voxel containing a coordinate along one axis.
+ */
+static int FLD_voxel(Field_t* f, float v, float origin) {
+
+	return (int)floorf((v - origin) / f->voxelSize);
+}
+
+/**
+ * State of the point regarding the distance of the field.
+ * The points outside the box of the field are free.
+ *
+ * @param f Field.
+ * @param p Point tested.
+ * @return (int) FIELD_FREE if every atom is far enough,
+ * FIELD_BLOCKED if an atom is closer than the distance,
+ * FIELD_BOUNDARY if an exact check is needed.
+ */
+int FLD_check(Field_t* f, Point_t p) {
+
+	int x = FLD_voxel(f, p.x, f->origin.x);
+	int y = FLD_voxel(f, p.y, f->origin.y);
+	int z = FLD_voxel(f, p.z, f->origin.z);
+
+	if (x < 0 || y < 0 || z < 0 || x >= f->nx || y >= f->ny || z >= f->nz)
+		return FIELD_FREE;
+
+	return voxel(f,x,y,z);
+}
+
+/**
+ * Creation of the occupancy field of a molecule.
+ * A voxel is blocked if all its points are closer than distance to an atom,
+ * free if all its points are farther than distance from every atom,
+ * and on the boundary otherwise.
+ *
+ * @param m Molecule.
+ * @param distance Distance to the atoms tested by the field.
+ * @param voxelSize Size of the edge of a voxel.
+ * @return (Field_t*) Occupancy field of the molecule.
+ */
+Field_t* FLD_create(Molecule_t* m, float distance, float voxelSize) {
+
+	int i, x, y, z;
+	Point_t min = {FLT_MAX, FLT_MAX, FLT_MAX}, max = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+	Field_t* f = malloc(sizeof(Field_t));
+	// Distance between the center of a voxel and its corners (with a margin for the rounding errors).
+	float halfDiagonal = voxelSize * sqrtf(3) / 2 + FIELD_MARGIN;
+	float reach = distance + halfDiagonal;
+
+	for (i = 0; i < size(m); i++) {
+		Point_t A = coords(atom(m,i));
+		min.x = fminf(min.x, A.x); max.x = fmaxf(max.x, A.x);
+		min.y = fminf(min.y, A.y); max.y = fmaxf(max.y, A.y);
+		min.z = fminf(min.z, A.z); max.z = fmaxf(max.z, A.z);
+	}
+
+	f->voxelSize = voxelSize;
+	f->origin.x = min.x - reach;
+	f->origin.y = min.y - reach;
+	f->origin.z = min.z - reach;
+	f->nx = (int)ceilf((max.x - min.x + 2 * reach) / voxelSize) + 1;
+	f->ny = (int)ceilf((max.y - min.y + 2 * reach) / voxelSize) + 1;
+	f->nz = (int)ceilf((max.z - min.z + 2 * reach) / voxelSize) + 1;
+	f->voxels = malloc(f->nx * f->ny * f->nz * sizeof(char));
+	memset(f->voxels, FIELD_FREE, f->nx * f->ny * f->nz * sizeof(char));
+
+	// Each atom marks the voxels around it.
+	for (i = 0; i < size(m); i++) {
+		Point_t A = coords(atom(m,i));
+		int x1 = FLD_voxel(f, A.x - reach, f->origin.x), x2 = FLD_voxel(f, A.x + reach, f->origin.x);
+		int y1 = FLD_voxel(f, A.y - reach, f->origin.y), y2 = FLD_voxel(f, A.y + reach, f->origin.y);
+		int z1 = FLD_voxel(f, A.z - reach, f->origin.z), z2 = FLD_voxel(f, A.z + reach, f->origin.z);
+
+		for (z = z1; z <= z2; z++)
+			for (y = y1; y <= y2; y++)
+				for (x = x1; x <= x2; x++) {
+					Point_t center = {
+						f->origin.x + (x + 0.5) * voxelSize,
+						f->origin.y + (y + 0.5) * voxelSize,
+						f->origin.z + (z + 0.5) * voxelSize
+					};
+					float d = dist(A, center);
+
+					if (d < distance - halfDiagonal)
+						voxel(f,x,y,z) = FIELD_BLOCKED;
+					else if (d < reach && voxel(f,x,y,z) == FIELD_FREE)
+						voxel(f,x,y,z) = FIELD_BOUNDARY;
+				}
+	}
+
+	return f;
+}
+
+void FLD_delete(Field_t* f) {
+
+	if (f != NULL)
+		free(f->voxels);
+	free(f);
+}
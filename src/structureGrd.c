@@ -0,0 +1,247 @@
+#include "structure.h"
+#include "util.h"
+#include <math.h>
+
+/**************************************/
+/* GRID *******************************/
+/**************************************/
+
+/**
+ * Index of the bucket of a cell.
+ * The cells are hashed in a fixed number of buckets (nbCells is a power of 2).
+ *
+ * @param g Grid.
+ * @param x, y, z Coordinates of the cell.
+ */
+static unsigned GRD_hash(Grid_t* g, int x, int y, int z) {
+
+	return ((unsigned)x * 73856093u ^ (unsigned)y * 19349663u ^ (unsigned)z * 83492791u) & (g->nbCells - 1);
+}
+
+/**
+ * Coordinate of the cell containing a value.
+ */
+static int GRD_cell(Grid_t* g, float v) {
+
+	return (int)floorf(v / g->cellSize);
+}
+
+/**
+ * Add memory for atoms up to the index id.
+ *
+ * @param g Grid.
+ * @param id Index of an atom.
+ */
+static void GRD_addAlloc(Grid_t* g, unsigned id) {
+
+	int i, newSize = size(g);
+
+	while (newSize <= id)
+		newSize += REALLOCSIZE;
+
+	g->next = realloc(g->next, newSize*sizeof(int));
+	g->bucket = realloc(g->bucket, newSize*sizeof(int));
+	g->coords = realloc(g->coords, newSize*sizeof(Point_t));
+
+	for (i=size(g); i<newSize; i++) {
+		g->next[i] = -1;
+		g->bucket[i] = -1;
+	}
+
+	size(g) = newSize;
+}
+
+/**
+ * Add an atom in the grid.
+ * If the atom was already in the grid, it is moved to its new position.
+ *
+ * @param g Grid.
+ * @param id Index of the atom (in the shell or in the molecule).
+ * @param p Position of the atom.
+ */
+void GRD_addAtom(Grid_t* g, unsigned id, Point_t p) {
+
+	unsigned b;
+
+	if (id < size(g) && g->bucket[id] != -1)
+		GRD_removeAtom(g, id);
+
+	if (id >= size(g))
+		GRD_addAlloc(g, id);
+
+	b = GRD_hash(g, GRD_cell(g, p.x), GRD_cell(g, p.y), GRD_cell(g, p.z));
+	g->coords[id] = p;
+	g->bucket[id] = b;
+	g->next[id] = g->head[b];
+	g->head[b] = id;
+}
+
+/**
+ * Remove an atom from the grid.
+ *
+ * @param g Grid.
+ * @param id Index of the atom.
+ */
+void GRD_removeAtom(Grid_t* g, unsigned id) {
+
+	int* i;
+
+	if (id >= size(g) || g->bucket[id] == -1)
+		return;
+
+	for (i = g->head + g->bucket[id]; *i != id; i = g->next + *i);
+	*i = g->next[id];
+
+	g->next[id] = -1;
+	g->bucket[id] = -1;
+}
+
+/**
+ * Check if an atom of the grid is closer than a given distance to a point.
+ * Only the cells around the point are browsed.
+ *
+ * @param g Grid.
+ * @param p Point tested.
+ * @param distance Distance under which an atom is found.
+ * @param except Index of an atom ignored (-1 to test all the atoms).
+ * @return (int) 1 if an atom is closer than distance, 0 otherwise.
+ */
+int GRD_checkDistance(Grid_t* g, Point_t p, float distance, int except) {
+
+	int x, y, z, i;
+	int range = (int)ceilf(distance / g->cellSize);
+	int cx = GRD_cell(g, p.x), cy = GRD_cell(g, p.y), cz = GRD_cell(g, p.z);
+
+	for (x = cx-range; x <= cx+range; x++)
+		for (y = cy-range; y <= cy+range; y++)
+			for (z = cz-range; z <= cz+range; z++)
+				for (i = g->head[GRD_hash(g, x, y, z)]; i != -1; i = g->next[i])
+					if (i != except && dist(g->coords[i], p) < distance)
+						return 1;
+
+	return 0;
+}
+
+/**
+ * List the atoms of the grid closer than a given distance to a point (each one once).
+ *
+ * @param g Grid.
+ * @param p Point tested.
+ * @param distance Distance under which an atom is listed.
+ * @param found List of the atoms found (its previous elements are overwritten).
+ * @return (int) Number of atoms found.
+ */
+int GRD_getAtoms(Grid_t* g, Point_t p, float distance, List_t* found) {
+
+	int x, y, z, i, nbFound = 0;
+	int range = (int)ceilf(distance / g->cellSize);
+	int cx = GRD_cell(g, p.x), cy = GRD_cell(g, p.y), cz = GRD_cell(g, p.z);
+
+	for (x = cx-range; x <= cx+range; x++)
+		for (y = cy-range; y <= cy+range; y++)
+			for (z = cz-range; z <= cz+range; z++)
+				for (i = g->head[GRD_hash(g, x, y, z)]; i != -1; i = g->next[i])
+					// The cells sharing a bucket are browsed several times: an atom is listed from its own cell.
+					if (GRD_cell(g, g->coords[i].x) == x && GRD_cell(g, g->coords[i].y) == y && GRD_cell(g, g->coords[i].z) == z
+							&& dist(g->coords[i], p) < distance) {
+						if (nbFound == size(found))
+							LST_addAlloc(found);
+						elts(found, nbFound++) = i;
+					}
+
+	if (nbFound < size(found))
+		elts(found, nbFound) = -1;
+
+	return nbFound;
+}
+
+/**
+ * Allocate an empty grid.
+ *
+ * @param cellSize Size of the edge of a cell.
+ * @param nbCells Number of buckets (power of 2).
+ */
+Grid_t* GRD_create(float cellSize, unsigned nbCells) {
+
+	int i;
+	Grid_t* g = malloc(sizeof(Grid_t));
+
+	g->cellSize = cellSize;
+	g->nbCells = nbCells;
+	g->head = malloc(nbCells*sizeof(int));
+	for (i=0; i<nbCells; i++)
+		g->head[i] = -1;
+
+	g->next = NULL;
+	g->bucket = NULL;
+	g->coords = NULL;
+	size(g) = 0;
+
+	return g;
+}
+
+/**
+ * Index the atoms of a shell (the atoms of flag NOT_DEF_F are ignored).
+ *
+ * @param s Shell.
+ * @return (Grid_t*) Grid of the atoms of the shell.
+ */
+Grid_t* GRD_createFromShell(Shell_t* s) {
+
+	int i;
+	Grid_t* g = GRD_create(GRID_CELL_SIZE, GRID_NB_CELLS);
+
+	for (i=size(s)-1; i>=0; i--)
+		if (flag(atom(s,i)) != NOT_DEF_F)
+			GRD_addAtom(g, i, coords(atom(s,i)));
+
+	return g;
+}
+
+/**
+ * Index the atoms of a molecule.
+ *
+ * @param m Molecule.
+ * @return (Grid_t*) Grid of the atoms of the molecule.
+ */
+Grid_t* GRD_createFromMolecule(Molecule_t* m) {
+
+	int i;
+	Grid_t* g = GRD_create(GRID_CELL_SIZE, GRID_NB_CELLS);
+
+	for (i=size(m)-1; i>=0; i--)
+		GRD_addAtom(g, i, coords(atom(m,i)));
+
+	return g;
+}
+
+Grid_t* GRD_copy(Grid_t* g) {
+
+	Grid_t* copy = malloc(sizeof(Grid_t));
+
+	copy->cellSize = g->cellSize;
+	copy->nbCells = g->nbCells;
+	size(copy) = size(g);
+
+	copy->head = malloc(g->nbCells*sizeof(int));
+	memcpy(copy->head, g->head, g->nbCells*sizeof(int));
+	copy->next = malloc(size(g)*sizeof(int));
+	memcpy(copy->next, g->next, size(g)*sizeof(int));
+	copy->bucket = malloc(size(g)*sizeof(int));
+	memcpy(copy->bucket, g->bucket, size(g)*sizeof(int));
+	copy->coords = malloc(size(g)*sizeof(Point_t));
+	memcpy(copy->coords, g->coords, size(g)*sizeof(Point_t));
+
+	return copy;
+}
+
+void GRD_delete(Grid_t* g) {
+
+	if (g != NULL) {
+		free(g->head);
+		free(g->next);
+		free(g->bucket);
+		free(g->coords);
+	}
+	free(g);
+}
@@ -205,6 +205,20 @@ void LSTm_removeFirst(List_m* list) {
 	free(suppr);
 }
 
+// Ajout d'une liste au début (dans son ordre), la liste ajoutée est libérée.
+void LSTm_addList(List_m* list, List_m* added) {
+
+	Elem* last = added->first;
+
+	if (last) {
+		while (last->next)
+			last = last->next;
+		last->next = list->first;
+		list->first = added->first;
+	}
+	free(added);
+}
+
 void LSTm_delete(List_m* list) {
 
 	while (list->first)
@@ -216,6 +230,44 @@ void LSTm_delete(List_m* list) {
 
 /******************************/
 
+List_r* LSTr_init() {
+	
+	List_r* list = malloc(sizeof(List_r));
+	list->first = NULL;
+	
+	return list;
+}
+
+// Ajout au début
+void LSTr_addElement(List_r* list, Trail_t* move) {
+	
+	Elem_r* elem = malloc(sizeof(Elem_r));
+	
+	elem->move = move;
+	elem->next = list->first;
+	
+	list->first = elem;
+}
+
+void LSTr_removeFirst(List_r* list) {
+	
+	Elem_r* suppr = list->first;
+	list->first = list->first->next;
+	TRL_delete(suppr->move);
+	free(suppr);
+}
+
+void LSTr_delete(List_r* list) {
+
+	while (list->first)
+	{
+		LSTr_removeFirst(list);
+	}
+	free(list);
+}
+
+/******************************/
+
 List_s* LSTs_init() {
 	
 	List_s* list = malloc(sizeof(List_s));
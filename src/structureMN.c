@@ -7,6 +7,7 @@ void MN_initMoc(Shell_t* s) {
 	s->atoms = NULL;
 	s->cycle = NULL;
 	s->bond = NULL;
+	s->grid = NULL;
 }
 
 void MN_addAlloc(Main_t* m, unsigned size) {
@@ -62,6 +63,10 @@ Main_t* MN_create() {
 	m->envarom = NULL;
 	m->mocs = NULL;
 	m->mocSize = 0;
+	m->cages = NULL;
+	memset(&m->budget, 0, sizeof(Budget_t));
+	m->spool = NULL;
+	m->pipe = NULL;
 
 	return m;
 }
@@ -87,5 +92,7 @@ void MN_delete(Main_t* m) {
 		free(m->mocs);
 	}
 
+	TBL_delete(m->cages);
+
 	free(m);
 }
@@ -250,6 +250,8 @@ Molecule_t* MOL_create(unsigned size) {
 
 	m->cycle = NULL;
 	m->bond = GPH_create();
+	m->grid = NULL;
+	m->field = NULL;
 
 	return m;
 }
@@ -277,7 +279,10 @@ void MOL_delete(Molecule_t* m) {
 	}
 
 	free(m->atoms);
-	LST_delete(m->cycle);
+	if (m->cycle != NULL) // Not computed if the molecule could not be read.
+		LST_delete(m->cycle);
 	GPH_delete(m->bond);
+	GRD_delete(m->grid);
+	FLD_delete(m->field);
 	free(m);
 }
\ No newline at end of file
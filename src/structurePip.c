@@ -0,0 +1,114 @@
+#include "structure.h"
+
+/**************************************/
+/* PIPE *******************************/
+/**************************************/
+
+/**
+ * Allocate an empty pipe.
+ *
+ * @param size Maximal number of results waiting.
+ */
+Pipe_t* PIP_create(int size) {
+
+	Pipe_t* p = malloc(sizeof(Pipe_t));
+
+	p->items = malloc(size*sizeof(Result_t));
+	p->first = 0;
+	p->nbItems = 0;
+	size(p) = size;
+	p->closed = 0;
+	pthread_mutex_init(&p->lock, NULL);
+	pthread_cond_init(&p->ready, NULL);
+
+	return p;
+}
+
+/**
+ * Delete a pipe and the results left in it.
+ */
+void PIP_delete(Pipe_t* p) {
+
+	if (p != NULL) {
+		for (; p->nbItems > 0; p->nbItems--)
+			SHL_delete(p->items[(p->first + p->nbItems - 1) % size(p)].moc);
+		pthread_mutex_destroy(&p->lock);
+		pthread_cond_destroy(&p->ready);
+		free(p->items);
+	}
+	free(p);
+}
+
+/**
+ * Push a result at the end of the pipe (by a search thread).
+ *
+ * @param p Pipe.
+ * @param moc Connected cage (owned by the pipe if it is pushed).
+ * @param n Index of the result.
+ * @param pathlessSize Size of its pathless cage.
+ * @return (int) 1 if the result is pushed, 0 if the pipe is full (the caller writes it).
+ */
+int PIP_push(Pipe_t* p, Shell_t* moc, int n, int pathlessSize) {
+
+	int pushed = 0;
+
+	pthread_mutex_lock(&p->lock);
+	if (p->nbItems < size(p)) {
+		Result_t* r = p->items + (p->first + p->nbItems++) % size(p);
+		r->moc = moc;
+		r->n = n;
+		r->pathlessSize = pathlessSize;
+		pushed = 1;
+		pthread_cond_signal(&p->ready);
+	}
+	pthread_mutex_unlock(&p->lock);
+
+	return pushed;
+}
+
+/**
+ * Pop the oldest result of the pipe (by the writing stage).
+ * Waits for a result while the pipe is empty and not closed.
+ *
+ * @param p Pipe.
+ * @param r Set to the result (its cage is owned by the caller).
+ * @return (int) 1 if a result is popped, 0 if the pipe is empty and closed.
+ */
+int PIP_pop(Pipe_t* p, Result_t* r) {
+
+	int popped = 0;
+
+	pthread_mutex_lock(&p->lock);
+	while (p->nbItems == 0 && !p->closed)
+		pthread_cond_wait(&p->ready, &p->lock);
+	if (p->nbItems > 0) {
+		*r = p->items[p->first];
+		p->first = (p->first + 1) % size(p);
+		p->nbItems--;
+		popped = 1;
+	}
+	pthread_mutex_unlock(&p->lock);
+
+	return popped;
+}
+
+/**
+ * Open the pipe before the search threads start (the writing stage waits for their results).
+ */
+void PIP_open(Pipe_t* p) {
+
+	pthread_mutex_lock(&p->lock);
+	p->closed = 0;
+	pthread_mutex_unlock(&p->lock);
+}
+
+/**
+ * Close the pipe once the search threads are stopped (the writing stage pops the results left, then returns).
+ */
+void PIP_close(Pipe_t* p) {
+
+	pthread_mutex_lock(&p->lock);
+	p->closed = 1;
+	pthread_cond_broadcast(&p->ready);
+	pthread_mutex_unlock(&p->lock);
+}
@@ -0,0 +1,101 @@
+#include "structure.h"
+
+/**************************************/
+/* PARTITION **************************/
+/**************************************/
+
+/**
+ * Representative of the component of an atom (with path halving).
+ * The atoms not indexed by the partition are alone in their component.
+ *
+ * @param p Partition.
+ * @param id Index of the atom.
+ * @return (int) Index of the representative atom.
+ */
+int PRT_find(Partition_t* p, int id) {
+
+	if (id < 0 || id >= size(p))
+		return id;
+
+	while (p->parent[id] != id) {
+		p->parent[id] = p->parent[p->parent[id]];
+		id = p->parent[id];
+	}
+	return id;
+}
+
+/**
+ * Merge the components of two atoms.
+ * The representative is the smallest index, so that the labels do not depend on the order of the merges.
+ *
+ * @param p Partition.
+ * @param id1, id2 Atoms.
+ */
+void PRT_union(Partition_t* p, int id1, int id2) {
+
+	int r1 = PRT_find(p, id1), r2 = PRT_find(p, id2);
+
+	if (r1 == r2 || r1 < 0 || r2 < 0 || r1 >= size(p) || r2 >= size(p))
+		return;
+
+	if (r1 < r2)
+		p->parent[r2] = r1;
+	else
+		p->parent[r1] = r2;
+}
+
+/**
+ * Allocate a partition where each atom is alone in its component.
+ *
+ * @param size Number of atoms.
+ */
+Partition_t* PRT_create(unsigned size) {
+
+	int i;
+	Partition_t* p = malloc(sizeof(Partition_t));
+
+	p->parent = malloc(size*sizeof(int));
+	for (i=0; i<size; i++)
+		p->parent[i] = i;
+	size(p) = size;
+
+	return p;
+}
+
+/**
+ * Connected components of the atoms of a shell (the atoms of flag NOT_DEF_F are ignored).
+ *
+ * @param s Shell.
+ * @return (Partition_t*) Partition of the atoms of the shell.
+ */
+Partition_t* PRT_createFromShell(Shell_t* s) {
+
+	int i, j;
+	Partition_t* p = PRT_create(size(s));
+
+	for (i=0; i<size(s); i++)
+		if (flag(atom(s,i)) != NOT_DEF_F)
+			for (j=0; j<neighborhoodSize(atom(s,i)); j++)
+				if (neighbor(atom(s,i),j) != -1)
+					PRT_union(p, i, neighbor(atom(s,i),j));
+
+	return p;
+}
+
+Partition_t* PRT_copy(Partition_t* p) {
+
+	Partition_t* copy = malloc(sizeof(Partition_t));
+
+	size(copy) = size(p);
+	copy->parent = malloc(size(p)*sizeof(int));
+	memcpy(copy->parent, p->parent, size(p)*sizeof(int));
+
+	return copy;
+}
+
+void PRT_delete(Partition_t* p) {
+
+	if (p != NULL)
+		free(p->parent);
+	free(p);
+}
@@ -0,0 +1,153 @@
+#include "structure.h"
+
+/**************************************/
+/* PRIORITY QUEUE *********************/
+/**************************************/
+
+/**
+ * Allocate a partial path.
+ *
+ * @param path Changes of the cage since the start of the search (owned by the state).
+ * @param idStart Last atom of the path.
+ * @param nbCarbonyls Number of consecutive carbonyl patterns.
+ * @param nbAroRings Number of aromatic rings.
+ * @param cost Cost of the path (lowest first).
+ */
+State_t* STA_create(Trail_t* path, int idStart, int nbCarbonyls, int nbAroRings, float cost) {
+
+	State_t* s = malloc(sizeof(State_t));
+
+	s->path = path;
+	s->idStart = idStart;
+	s->nbCarbonyls = nbCarbonyls;
+	s->nbAroRings = nbAroRings;
+	s->nbAtoms = 0;
+	s->cost = cost;
+	s->order = 0;
+
+	return s;
+}
+
+void STA_delete(State_t* s) {
+
+	TRL_delete(s->path);
+	free(s);
+}
+
+/**
+ * Order of the states: lowest cost first, then first inserted first.
+ */
+static int QUE_before(State_t* s1, State_t* s2) {
+
+	return s1->cost < s2->cost || (s1->cost == s2->cost && s1->order < s2->order);
+}
+
+static void QUE_swap(Queue_t* q, int i, int j) {
+
+	State_t* tmp = q->states[i];
+	q->states[i] = q->states[j];
+	q->states[j] = tmp;
+}
+
+static void QUE_siftUp(Queue_t* q, int i) {
+
+	while (i > 0 && QUE_before(q->states[i], q->states[(i-1)/2])) {
+		QUE_swap(q, i, (i-1)/2);
+		i = (i-1)/2;
+	}
+}
+
+static void QUE_siftDown(Queue_t* q, int i) {
+
+	while (2*i+1 < q->nbStates) {
+		int child = 2*i+1;
+
+		if (child+1 < q->nbStates && QUE_before(q->states[child+1], q->states[child]))
+			child++;
+		if (!QUE_before(q->states[child], q->states[i]))
+			break;
+		QUE_swap(q, i, child);
+		i = child;
+	}
+}
+
+/**
+ * Insert a state in the queue.
+ * When the queue is full, the worst state (the new one or one of the queue) is deleted.
+ *
+ * @param q Queue.
+ * @param s State (owned by the queue).
+ */
+void QUE_push(Queue_t* q, State_t* s) {
+
+	int i, worst;
+
+	s->order = q->nbPushed++;
+
+	if (q->nbStates == size(q)) {
+		// The worst state is a leaf of the heap.
+		worst = q->nbStates/2;
+		for (i = worst+1; i < q->nbStates; i++)
+			if (QUE_before(q->states[worst], q->states[i]))
+				worst = i;
+
+		if (!QUE_before(s, q->states[worst])) {
+			STA_delete(s);
+			q->nbDropped++;
+			return;
+		}
+		STA_delete(q->states[worst]);
+		q->nbDropped++;
+		q->states[worst] = s;
+		QUE_siftUp(q, worst);
+		return;
+	}
+
+	q->states[q->nbStates] = s;
+	QUE_siftUp(q, q->nbStates++);
+}
+
+/**
+ * Remove the best state of the queue.
+ *
+ * @return (State_t*) State of lowest cost, NULL if the queue is empty.
+ */
+State_t* QUE_pop(Queue_t* q) {
+
+	State_t* s;
+
+	if (q->nbStates == 0)
+		return NULL;
+
+	s = q->states[0];
+	q->states[0] = q->states[--q->nbStates];
+	QUE_siftDown(q, 0);
+
+	return s;
+}
+
+/**
+ * Allocate an empty queue.
+ *
+ * @param size Maximal number of states.
+ */
+Queue_t* QUE_create(unsigned size) {
+
+	Queue_t* q = malloc(sizeof(Queue_t));
+
+	q->states = malloc(size*sizeof(State_t*));
+	q->nbStates = 0;
+	q->nbPushed = 0;
+	q->nbDropped = 0;
+	size(q) = size;
+
+	return q;
+}
+
+void QUE_delete(Queue_t* q) {
+
+	while (q->nbStates > 0)
+		STA_delete(q->states[--q->nbStates]);
+	free(q->states);
+	free(q);
+}
@@ -140,9 +140,49 @@ unsigned SHL_addAtom(Shell_t* s, Point_t coords, unsigned parent) {
 	coords(atom(s,indice)) = coords;
 	parentAtom(atom(s,indice)) = parent;
 
+	if (s->grid != NULL)
+		GRD_addAtom(s->grid, indice, coords);
+
 	return indice;
 }
 
+static int SHL_compareIndices(const void* a, const void* b) {
+
+	return *(const int*)a - *(const int*)b;
+}
+
+/**
+ * List the atoms of a shell closer than a given distance to a point, by increasing index.
+ * The grid of the shell is used if it is built, otherwise every atom is tested.
+ *
+ * @param s Shell.
+ * @param p Point tested.
+ * @param distance Distance under which an atom is listed.
+ * @param found List of the atoms found (its previous elements are overwritten).
+ * @return (int) Number of atoms found.
+ */
+int SHL_getAtoms(Shell_t* s, Point_t p, float distance, List_t* found) {
+
+	int i, nbFound = 0;
+
+	if (s->grid != NULL) {
+		nbFound = GRD_getAtoms(s->grid, p, distance, found);
+		qsort(found->elts, nbFound, sizeof(int), SHL_compareIndices);
+		return nbFound;
+	}
+
+	for (i=0; i<size(s); i++)
+		if (flag(atom(s,i)) != NOT_DEF_F && dist(coords(atom(s,i)), p) < distance) {
+			if (nbFound == size(found))
+				LST_addAlloc(found);
+			elts(found, nbFound++) = i;
+		}
+	if (nbFound < size(found))
+		elts(found, nbFound) = -1;
+
+	return nbFound;
+}
+
 void SHL_removeAtom(Shell_t* s, unsigned id) {
 
 	int i;
@@ -161,6 +201,8 @@ void SHL_removeAtom(Shell_t* s, unsigned id) {
 
 		if (checkVertex(s,id))
 			SHL_removeVertex(s, id);
+		if (s->grid != NULL)
+			GRD_removeAtom(s->grid, id);
 		SHL_initAtom(a);
 	}
 }
@@ -289,6 +331,8 @@ void SHL_mergeAtom2(Shell_t* s, unsigned id1, unsigned id2) {
 		}
 
 		coords(a1) = merPoint(coords(a1), coords(a2));
+		if (s->grid != NULL)
+			GRD_addAtom(s->grid, id1, coords(a1));
 
 		SHL_removeAtom(s, id2);
 	}
@@ -302,6 +346,7 @@ Shell_t* SHL_create() {
 	a->atoms = NULL;
 	a->cycle = LST_create();
 	a->bond = GPH_create();
+	a->grid = NULL;
 
 	return a;
 }
@@ -315,6 +360,7 @@ Shell_t* SHL_copy(Shell_t* s) {
 	copy->atoms = malloc(size(copy)*sizeof(AtomShl_t));
 	copy->cycle = LST_copy(s->cycle);
 	copy->bond = GPH_copy(s->bond);
+	copy->grid = (s->grid != NULL) ? GRD_copy(s->grid) : NULL;
 
 
 	for (i=0; i<size(s); i++) {
@@ -364,6 +410,7 @@ Shell_t* SHL_copyCageAtoms(Shell_t* s) { //copie un shell_t en enelevant les ato
 		}
 	}
 	free(mod_pos_nei);
+	copy->grid = (s->grid != NULL) ? GRD_createFromShell(copy) : NULL;
 	return copy;
 }
 
@@ -407,27 +454,33 @@ Shell_t* SHL_copyCageAtoms(Shell_t* s) { //copie un shell_t en enelevant les ato
 
 void SHL_testDis(Shell_t* s) {
 
-int i, j;
+int i, j, k;
+List_t* around = LST_create(); // Atoms closer than MINDIS to the atom i (listed again when it moves).
 	for (i = 0; i < size(s); i++) {
 		if (flag(atom(s,i)) != NOT_DEF_F && flag(atom(s,i)) != CYCLE_F && flag(atom(s,i)) != SHELL_F) {
-			for (j = i + 1; j < size(s); j++) {
-				if (flag(atom(s,j)) != NOT_DEF_F && flag(atom(s,j)) != CYCLE_F && flag(atom(s,j)) != SHELL_F) {
-					if (dist(coords(atom(s,i)), coords(atom(s,j))) < MINDIS) {
-						if (flag(atom(s,i)) == LINKABLE_F && flag(atom(s,j)) == HYDRO_BOND_F) {
-							SHL_removeAtom(s, i);
-						}
-						else if (flag(atom(s,i)) == HYDRO_BOND_F && flag(atom(s,j)) == LINKABLE_F) {
-							SHL_removeAtom(s, j);
-						}else {
-							if (flag(atom(s,i)) == LINKABLE_F && flag(atom(s,j)) == LINKABLE_F) 
-								flag(atom(s,i)) = CARBON_F; // Change the flag when both linkable to prevent choosing them as the starting or ending atom.
-							SHL_mergeAtom2(s, i, j);
-						}
+			SHL_getAtoms(s, coords(atom(s,i)), MINDIS, around);
+			for (k = 0; forEachElement(around, k) && flag(atom(s,i)) != NOT_DEF_F; k++) {
+				j = elts(around, k);
+				if (j > i && flag(atom(s,j)) != NOT_DEF_F && flag(atom(s,j)) != CYCLE_F && flag(atom(s,j)) != SHELL_F) {
+					if (flag(atom(s,i)) == LINKABLE_F && flag(atom(s,j)) == HYDRO_BOND_F) {
+						SHL_removeAtom(s, i);
+					}
+					else if (flag(atom(s,i)) == HYDRO_BOND_F && flag(atom(s,j)) == LINKABLE_F) {
+						SHL_removeAtom(s, j);
+					}else {
+						if (flag(atom(s,i)) == LINKABLE_F && flag(atom(s,j)) == LINKABLE_F) 
+							flag(atom(s,i)) = CARBON_F; // Change the flag when both linkable to prevent choosing them as the starting or ending atom.
+						SHL_mergeAtom2(s, i, j);
+						// The atom i moved: the next atoms are the ones close to its new position.
+						SHL_getAtoms(s, coords(atom(s,i)), MINDIS, around);
+						for (k = 0; forEachElement(around, k) && elts(around, k) <= j; k++);
+						k--;
 					}
 				}
 			}
 		}
 	}
+LST_delete(around);
 }
 
 void SHL_deleteAtom(AtomShl_t* a) {
@@ -451,5 +504,7 @@ void SHL_delete(Shell_t* s) {
 	if (s->bond != NULL)
 		GPH_delete(s->bond);
 
+	GRD_delete(s->grid);
+
 	free(s);
 }
@@ -0,0 +1,195 @@
+#include "structure.h"
+#include <math.h>
+
+/**************************************/
+/* TABLE OF THE CAGES *****************/
+/**************************************/
+
+/**
+ * Mix the bits of a key (finalizer of splitmix64).
+ */
+unsigned long TBL_mix(unsigned long key) {
+
+	key ^= key >> 30;
+	key *= 0xbf58476d1ce4e5b9UL;
+	key ^= key >> 27;
+	key *= 0x94d049bb133111ebUL;
+	key ^= key >> 31;
+
+	return key;
+}
+
+/**
+ * Hash of a position quantized with a step of TABLE_QUANTUM.
+ */
+unsigned long TBL_hashPoint(Point_t p) {
+
+	unsigned long x = (unsigned long)lroundf(p.x / TABLE_QUANTUM);
+	unsigned long y = (unsigned long)lroundf(p.y / TABLE_QUANTUM);
+	unsigned long z = (unsigned long)lroundf(p.z / TABLE_QUANTUM);
+
+	return TBL_mix(TBL_mix(TBL_mix(x) ^ y) ^ z);
+}
+
+/**
+ * Fingerprint of the atoms of a shell (quantized positions and flags).
+ * The hashes of the atoms are summed, so it does not depend on the indices
+ * nor on the order in which the atoms were added.
+ *
+ * @param s Shell.
+ * @return (unsigned long) Fingerprint of the shell.
+ */
+unsigned long TBL_fingerprint(Shell_t* s) {
+
+	int i;
+	unsigned long fingerprint = 0;
+
+	for (i=0; i<size(s); i++)
+		if (flag(atom(s,i)) != NOT_DEF_F)
+			fingerprint += TBL_mix(TBL_hashPoint(coords(atom(s,i))) ^ (unsigned long)flag(atom(s,i)));
+
+	return fingerprint;
+}
+
+/**
+ * Remove a slot from the LRU list of its stripe.
+ */
+static void TBL_unlink(Stripe_t* st, int id) {
+
+	Slot_t* slot = st->slots + id;
+
+	if (slot->older != -1)
+		st->slots[slot->older].newer = slot->newer;
+	else
+		st->oldest = slot->newer;
+
+	if (slot->newer != -1)
+		st->slots[slot->newer].older = slot->older;
+	else
+		st->newest = slot->older;
+}
+
+/**
+ * Add a slot as the most recently used of its stripe.
+ */
+static void TBL_link(Stripe_t* st, int id) {
+
+	Slot_t* slot = st->slots + id;
+
+	slot->older = st->newest;
+	slot->newer = -1;
+	if (st->newest != -1)
+		st->slots[st->newest].newer = id;
+	else
+		st->oldest = id;
+	st->newest = id;
+}
+
+/**
+ * Check if a key is in the table and insert it otherwise.
+ * When its stripe is full, the least recently used key of the stripe is evicted.
+ *
+ * @param t Table.
+ * @param key Key of the state.
+ * @return (int) 1 if the key was already in the table, 0 otherwise.
+ */
+int TBL_checkAndInsert(Table_t* t, unsigned long key) {
+
+	Stripe_t* st = t->stripes + (key & (t->nbStripes - 1));
+	unsigned bucket = (key >> TABLE_STRIPE_BITS) & (st->size - 1);
+	int id, *i;
+
+	omp_set_lock(&st->lock);
+	st->nbLookups++;
+
+	for (id = st->heads[bucket]; id != -1; id = st->slots[id].next)
+		if (st->slots[id].key == key) {
+			st->nbHits++;
+			TBL_unlink(st, id);
+			TBL_link(st, id);
+			omp_unset_lock(&st->lock);
+			return 1;
+		}
+
+	if (st->nbSlots < st->size)
+		id = st->nbSlots++;
+	else { // Eviction of the least recently used key.
+		id = st->oldest;
+		TBL_unlink(st, id);
+		for (i = st->heads + ((st->slots[id].key >> TABLE_STRIPE_BITS) & (st->size - 1)); *i != id; i = &st->slots[*i].next);
+		*i = st->slots[id].next;
+		st->nbEvictions++;
+	}
+
+	st->slots[id].key = key;
+	st->slots[id].next = st->heads[bucket];
+	st->heads[bucket] = id;
+	TBL_link(st, id);
+
+	omp_unset_lock(&st->lock);
+	return 0;
+}
+
+/**
+ * Sum of the counters of the stripes.
+ *
+ * @param t Table.
+ * @param nbLookups, nbHits, nbEvictions Counters (output).
+ */
+void TBL_stats(Table_t* t, long* nbLookups, long* nbHits, long* nbEvictions) {
+
+	int i;
+
+	*nbLookups = *nbHits = *nbEvictions = 0;
+	for (i=0; i<t->nbStripes; i++) {
+		*nbLookups += t->stripes[i].nbLookups;
+		*nbHits += t->stripes[i].nbHits;
+		*nbEvictions += t->stripes[i].nbEvictions;
+	}
+}
+
+/**
+ * Allocate an empty table.
+ *
+ * @param size Maximal number of keys (power of 2, split between the 2^TABLE_STRIPE_BITS stripes).
+ */
+Table_t* TBL_create(unsigned size) {
+
+	int i, j;
+	Table_t* t = malloc(sizeof(Table_t));
+
+	t->nbStripes = 1 << TABLE_STRIPE_BITS;
+	t->stripes = malloc(t->nbStripes*sizeof(Stripe_t));
+
+	for (i=0; i<t->nbStripes; i++) {
+		Stripe_t* st = t->stripes + i;
+
+		size(st) = (size >> TABLE_STRIPE_BITS) > 0 ? size >> TABLE_STRIPE_BITS : 1;
+		st->slots = malloc(size(st)*sizeof(Slot_t));
+		st->heads = malloc(size(st)*sizeof(int));
+		for (j=0; j<size(st); j++)
+			st->heads[j] = -1;
+		st->nbSlots = 0;
+		st->oldest = st->newest = -1;
+		st->nbLookups = st->nbHits = st->nbEvictions = 0;
+		omp_init_lock(&st->lock);
+	}
+
+	return t;
+}
+
+void TBL_delete(Table_t* t) {
+
+	int i;
+
+	if (t == NULL)
+		return;
+
+	for (i=0; i<t->nbStripes; i++) {
+		free(t->stripes[i].slots);
+		free(t->stripes[i].heads);
+		omp_destroy_lock(&t->stripes[i].lock);
+	}
+	free(t->stripes);
+	free(t);
+}
@@ -0,0 +1,180 @@
+#include "structure.h"
+
+/**************************************/
+/* TRAIL ******************************/
+/**************************************/
+
+/**
+ * Add a change at the end of the trail.
+ */
+static void TRL_addChange(Trail_t* t, int type, int id1, int id2, int flag, Point_t coords) {
+
+	if (nbChanges(t) == size(t)) {
+		size(t) = (size(t) == 0) ? TRAIL_SIZE : 2*size(t);
+		t->changes = realloc(t->changes, size(t)*sizeof(Change_t));
+	}
+
+	t->changes[nbChanges(t)].type = type;
+	t->changes[nbChanges(t)].id1 = id1;
+	t->changes[nbChanges(t)].id2 = id2;
+	t->changes[nbChanges(t)].flag = flag;
+	t->changes[nbChanges(t)].coords = coords;
+	nbChanges(t)++;
+}
+
+/**
+ * Add an atom in the shell and record it in the trail.
+ *
+ * @param t Trail of the shell.
+ * @param s Shell.
+ * @param coords Position of the atom.
+ * @param flag Flag of the atom.
+ * @return (unsigned) Index of the atom in the shell.
+ */
+unsigned TRL_addAtom(Trail_t* t, Shell_t* s, Point_t coords, int flag) {
+
+	unsigned id = SHL_addAtom(s, coords, -1);
+	flag(atom(s,id)) = flag;
+
+	TRL_addChange(t, TRAIL_ATOM, id, -1, flag, coords);
+	return id;
+}
+
+/**
+ * Add an edge in the shell and record it in the trail (if it did not exist).
+ *
+ * @param t Trail of the shell.
+ * @param s Shell.
+ * @param id1, id2 Atoms of the edge.
+ */
+void TRL_addEdge(Trail_t* t, Shell_t* s, unsigned id1, unsigned id2) {
+
+	if (id1 < size(s) && id2 < size(s) && id1 != id2
+			&& !LST_check(neighborhood(atom(s,id1)), id2)) {
+		SHL_addEdge(s, id1, id2);
+		TRL_addChange(t, TRAIL_EDGE, id1, id2, 0, coords(atom(s,id1)));
+	}
+}
+
+/**
+ * Change the flag of an atom and record the previous one in the trail.
+ *
+ * @param t Trail of the shell.
+ * @param s Shell.
+ * @param id Atom.
+ * @param flag New flag of the atom.
+ */
+void TRL_setFlag(Trail_t* t, Shell_t* s, unsigned id, int flag) {
+
+	TRL_addChange(t, TRAIL_FLAG, id, flag, flag(atom(s,id)), coords(atom(s,id)));
+	flag(atom(s,id)) = flag;
+}
+
+/**
+ * Undo (in reverse order) the changes recorded after a mark.
+ *
+ * @param t Trail of the shell.
+ * @param s Shell.
+ * @param mark Number of changes to keep.
+ */
+void TRL_undo(Trail_t* t, Shell_t* s, unsigned mark) {
+
+	while (nbChanges(t) > mark) {
+		Change_t* c = t->changes + --nbChanges(t);
+
+		if (c->type == TRAIL_ATOM)
+			SHL_removeAtom(s, c->id1);
+		else if (c->type == TRAIL_EDGE)
+			SHL_removeEdge(s, c->id1, c->id2);
+		else
+			flag(atom(s,c->id1)) = c->flag;
+	}
+}
+
+/**
+ * Index of an atom in the shell where a move is replayed.
+ * The atoms added by the move may be at other indices than when it was recorded.
+ *
+ * @param move Move replayed.
+ * @param ids Indices of the atoms added by the previous changes of the move.
+ * @param i Index of the current change.
+ * @param id Index of the atom when the move was recorded.
+ */
+static int TRL_renumber(Trail_t* move, int* ids, int i, int id) {
+
+	int j;
+
+	for (j=i-1; j>=0; j--)
+		if (move->changes[j].type == TRAIL_ATOM && move->changes[j].id1 == id)
+			return ids[j];
+
+	return id;
+}
+
+/**
+ * Apply again the changes of a move.
+ * The move is recorded from the same state of the shell, or from a state with fewer atoms
+ * (the added atoms then take other indices, and the changes of the move are renumbered).
+ *
+ * @param t Trail of the shell.
+ * @param s Shell.
+ * @param move Changes to apply.
+ * @return (int) Index of the last atom added, -1 if the move adds no atom.
+ */
+int TRL_replay(Trail_t* t, Shell_t* s, Trail_t* move) {
+
+	int i, last = -1;
+	int buffer[TRAIL_SIZE];
+	int* ids = (nbChanges(move) <= TRAIL_SIZE) ? buffer : malloc(nbChanges(move)*sizeof(int));
+
+	for (i=0; i<nbChanges(move); i++) {
+		Change_t* c = move->changes + i;
+
+		if (c->type == TRAIL_ATOM)
+			ids[i] = last = TRL_addAtom(t, s, c->coords, c->flag);
+		else if (c->type == TRAIL_EDGE)
+			TRL_addEdge(t, s, TRL_renumber(move, ids, i, c->id1), TRL_renumber(move, ids, i, c->id2));
+		else
+			TRL_setFlag(t, s, TRL_renumber(move, ids, i, c->id1), c->id2);
+	}
+
+	if (ids != buffer)
+		free(ids);
+	return last;
+}
+
+/**
+ * Copy of the changes recorded after a mark.
+ *
+ * @param t Trail.
+ * @param mark Index of the first change copied.
+ * @return (Trail_t*) Move that can be replayed.
+ */
+Trail_t* TRL_copy(Trail_t* t, unsigned mark) {
+
+	Trail_t* copy = TRL_create();
+
+	size(copy) = nbChanges(copy) = nbChanges(t) - mark;
+	copy->changes = malloc(size(copy)*sizeof(Change_t));
+	memcpy(copy->changes, t->changes + mark, size(copy)*sizeof(Change_t));
+
+	return copy;
+}
+
+Trail_t* TRL_create() {
+
+	Trail_t* t = malloc(sizeof(Trail_t));
+
+	t->changes = NULL;
+	size(t) = 0;
+	nbChanges(t) = 0;
+
+	return t;
+}
+
+void TRL_delete(Trail_t* t) {
+
+	if (t != NULL)
+		free(t->changes);
+	free(t);
+}